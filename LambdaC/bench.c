@@ -0,0 +1,353 @@
+/*
+    bench.c
+
+    reduces the programs of lambda.test over and over and reports
+    throughput; build it with and without -DSOA_HEAP to compare the
+    two heap layouts (make bench).
+
+    usage: bench [-c] [-s] [-d] [-m memo_size] [-t] [-p] [-h heap_size] [rounds [file [top]]];
+    with top, only the top programs with the most reductions (the
+    beta-heavy ones) are timed, -c turns on the free-variable cache,
+    -s times lambda_reduce_normalized() instead of reduce_lambda(),
+    -d standardizes by de Bruijn lookup and -m remembers that many
+    normal forms (with -s).  -t instead measures hits in the shared
+    memo with 1 to 64 threads, each on its own handle, and -p the
+    parser's throughput in MB/s on a large generated expression.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "utilities.h"
+#include "lambda.h"
+
+#define	  MAX_PROGRAMS  1000
+#define	  MAX_THREADS   64
+
+/*-----------------------------------------------------------------*/
+
+static int
+read_suite (char *file, char **program)
+{
+  FILE *fp;
+  char *expr;
+  char *line;
+  int n;
+
+  fp = fopen (file, "r");
+  if (fp == NULL)
+    nrerror ("bench: cannot open test suite");
+
+  n = 0;
+  while (n < MAX_PROGRAMS && (line = get_line (fp)) != NULL && *line != '@')
+    {
+      expr = line;
+      while (str_index (expr, "eval") == -1)
+	{
+	  line = get_line (fp);
+	  if (line == NULL || *line == '@')
+	    break;
+	  expr = realloc (expr, strlen (expr) + strlen (line) + 1);
+	  strcat (expr, line);
+	  free (line);
+	}
+      program[n++] = expr;
+    }
+
+  fclose (fp);
+  return n;
+}
+
+/*-----------------------------------------------------------------*/
+
+/* keeps the top programs with the most reductions, in suite order */
+
+static int
+select_heavy (interpreter * Lambda, char **program, int n, int top)
+{
+  int reductions[MAX_PROGRAMS];
+  char *result;
+  int threshold;
+  int kept;
+  int i, j, above;
+
+  for (i = 0; i < n; i++)
+    {
+      result = reduce_lambda (program[i], Lambda);
+      reductions[i] = Lambda->reductions;
+      if (result)
+	free (result);
+    }
+
+  threshold = -1;		/* fewest reductions among the top */
+  for (i = 0; i < n; i++)
+    {
+      above = 0;
+      for (j = 0; j < n; j++)
+	if (reductions[j] > reductions[i])
+	  above++;
+      if (above < top && (threshold < 0 || reductions[i] < threshold))
+	threshold = reductions[i];
+    }
+
+  kept = 0;
+  for (i = 0; i < n && kept < top; i++)
+    if (reductions[i] >= threshold)
+      program[kept++] = program[i];
+    else
+      free (program[i]);
+  for (; i < n; i++)
+    free (program[i]);
+  return kept;
+}
+
+/*-----------------------------------------------------------------*/
+
+static double
+now (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/*-----------------------------------------------------------------*/
+
+struct sweep
+  {
+    parmsLambda *parms;
+    char **program;
+    int n;
+    int rounds;
+    int hits;
+  };
+
+static void *
+sweep_worker (void *arg)
+{
+  struct sweep *S;
+  interpreter *Lambda;
+  int r, i;
+
+  S = (struct sweep *) arg;
+  Lambda = lambda_open (S->parms);
+  for (r = 0; r < S->rounds; r++)
+    for (i = 0; i < S->n; i++)
+      lambda_reduce_normalized (Lambda, S->program[i]);
+  S->hits = Lambda->memo_shared_hits;
+  lambda_close (Lambda);
+  return NULL;
+}
+
+/* hit throughput of the shared memo, for programs it can answer */
+
+static void
+shared_sweep (parmsLambda * Parameters, char **suite, int n, int rounds)
+{
+  char *program[MAX_PROGRAMS];
+  struct sweep S[MAX_THREADS];
+  pthread_t thread[MAX_THREADS];
+  interpreter *Lambda;
+  double start, elapsed;
+  int hits, before;
+  int threads, kept, t, i;
+
+  Parameters->memo_size = 0;
+  if (Parameters->shared_memo == 0)
+    Parameters->shared_memo = 4096;
+
+  Lambda = lambda_open (Parameters);	/* fill the memo, keep what it answers */
+  kept = 0;
+  for (i = 0; i < n; i++)
+    {
+      lambda_reduce_normalized (Lambda, suite[i]);
+      before = Lambda->memo_shared_hits;
+      lambda_reduce_normalized (Lambda, suite[i]);
+      if (Lambda->memo_shared_hits > before)
+	program[kept++] = suite[i];
+    }
+  lambda_close (Lambda);
+
+  printf ("shared memo:   %d slots, %d of %d programs answered\n",
+	  Parameters->shared_memo, kept, n);
+  for (threads = 1; threads <= MAX_THREADS; threads *= 2)
+    {
+      start = now ();
+      for (t = 0; t < threads; t++)
+	{
+	  S[t].parms = Parameters;
+	  S[t].program = program;
+	  S[t].n = kept;
+	  S[t].rounds = rounds;
+	  pthread_create (&thread[t], NULL, sweep_worker, &S[t]);
+	}
+      hits = 0;
+      for (t = 0; t < threads; t++)
+	{
+	  pthread_join (thread[t], NULL);
+	  hits += S[t].hits;
+	}
+      elapsed = now () - start;
+      printf ("%2d threads:    %.0f hits/s (%.0f per thread), %.1f%% hits\n", threads,
+	      hits / elapsed, hits / elapsed / threads, 100.0 * hits / (threads * rounds * kept));
+    }
+}
+
+/*-----------------------------------------------------------------*/
+
+/*
+ * a closed term of some megabyte, a long chain of applications to
+ * identifiers and numbers, is parsed by Free_Variables() over and over
+ */
+
+#define	  PARSE_UNITS  200000
+
+static void
+parse_throughput (parmsLambda * Parameters, int rounds)
+{
+  static const char *unit[] = {")alpha12 ", ")beta ", ")31415 ", ")gamma7 ", ")2.718 "};
+  interpreter *Lambda;
+  char *expr, *p;
+  size_t length;
+  double start, elapsed;
+  int r, i;
+
+  expr = (char *) space (PARSE_UNITS * 12 + 100);
+  p = expr + sprintf (expr, "\\alpha12.\\beta.\\gamma7.");
+  memset (p, '(', PARSE_UNITS);
+  p += PARSE_UNITS;
+  p += sprintf (p, "beta");
+  for (i = 0; i < PARSE_UNITS; i++)
+    p += sprintf (p, "%s", unit[i % 5]);
+  length = p - expr;
+
+  Parameters->heap_size = 4 * PARSE_UNITS;
+  Parameters->stack_size = 4 * PARSE_UNITS;
+  Lambda = lambda_open (Parameters);
+  if (Free_Variables (expr, Lambda) != 0 || Lambda->errors_occurred)
+    nrerror ("bench: parse failed");
+
+  start = now ();
+  for (r = 0; r < rounds; r++)
+    Free_Variables (expr, Lambda);
+  elapsed = now () - start;
+
+  printf ("parse:         %.1f MB x %d rounds in %.3f s\n", length / 1e6, rounds, elapsed);
+  printf ("throughput:    %.1f MB/s\n", length * (double) rounds / elapsed / 1e6);
+
+  lambda_close (Lambda);
+  free (expr);
+}
+
+/*-----------------------------------------------------------------*/
+
+int
+main (int argc, char **argv)
+{
+  char *program[MAX_PROGRAMS];
+  char *result;
+  interpreter *Lambda;
+  parmsLambda Parameters;
+  double start, elapsed;
+  long reductions, cycles;
+  int normalize;
+  int sweep;
+  int parse;
+  int rounds, n, r, i;
+
+  lambda_default_parameters (&Parameters);
+  normalize = 0;
+  sweep = 0;
+  parse = 0;
+  while (argc > 1 && argv[1][0] == '-')
+    {
+      if (strcmp (argv[1], "-c") == 0)
+	Parameters.free_var_cache = 1;
+      else if (strcmp (argv[1], "-s") == 0)
+	normalize = 1;
+      else if (strcmp (argv[1], "-t") == 0)
+	sweep = 1;
+      else if (strcmp (argv[1], "-p") == 0)
+	parse = 1;
+      else if (strcmp (argv[1], "-d") == 0)
+	Parameters.de_bruijn = 1;
+      else if (strcmp (argv[1], "-m") == 0 && argc > 2)
+	{
+	  Parameters.memo_size = atoi (argv[2]);
+	  argc--;
+	  argv++;
+	}
+      else if (strcmp (argv[1], "-h") == 0 && argc > 2)
+	{
+	  Parameters.heap_size = atoi (argv[2]);
+	  argc--;
+	  argv++;
+	}
+      argc--;
+      argv++;
+    }
+
+  rounds = (argc > 1) ? atoi (argv[1]) : 200;
+  if (parse)
+    {
+      parse_throughput (&Parameters, rounds);
+      return 0;
+    }
+  n = read_suite ((argc > 2) ? argv[2] : "lambda.test", program);
+
+  if (sweep)
+    {
+      shared_sweep (&Parameters, program, n, rounds);
+      for (i = 0; i < n; i++)
+	free (program[i]);
+      return 0;
+    }
+
+  Lambda = lambda_open (&Parameters);
+  if (argc > 3)
+    n = select_heavy (Lambda, program, n, atoi (argv[3]));
+
+  reductions = cycles = 0;
+  start = now ();
+  for (r = 0; r < rounds; r++)
+    for (i = 0; i < n; i++)
+      {
+	if (normalize)
+	  lambda_reduce_normalized (Lambda, program[i]);	/* owned by Lambda */
+	else
+	  {
+	    result = reduce_lambda (program[i], Lambda);
+	    if (result)
+	      free (result);
+	  }
+	reductions += Lambda->reductions;
+	cycles += Lambda->cycles;
+      }
+  elapsed = now () - start;
+
+#ifdef SOA_HEAP
+  printf ("heap layout:   structure of arrays\n");
+#else
+  printf ("heap layout:   array of structures (%d bytes/node)\n", (int) sizeof (heap_node));
+#endif
+  printf ("heap size:     %d nodes\n", Parameters.heap_size);
+  printf ("free var cache: %s\n", Parameters.free_var_cache ? "on" : "off");
+  if (normalize)
+    printf ("standardize:   %s\n", Parameters.de_bruijn ? "de Bruijn lookup" : "scope() walks");
+  if (normalize && Parameters.memo_size > 0)
+    printf ("memo:          %d entries, %d hits, %d misses\n", Parameters.memo_size,
+	    Lambda->memo_hits, Lambda->memo_misses);
+  printf ("programs:      %d x %d rounds in %.3f s\n", n, rounds, elapsed);
+  printf ("reductions:    %ld\n", reductions);
+  printf ("throughput:    %.0f programs/s, %.0f reductions/s\n",
+	  n * rounds / elapsed, reductions / elapsed);
+  printf ("cycle time:    %.1f ns/cycle\n", elapsed * 1e9 / cycles);
+
+  lambda_close (Lambda);
+  for (i = 0; i < n; i++)
+    free (program[i]);
+  return 0;
+}
@@ -29,83 +29,220 @@ Translated and rewritten by
 
 #include <stdio.h>
 #include <math.h>
+#include <ctype.h>
+#include <limits.h>
 #include <string.h>
+#include <stddef.h>
 #include <setjmp.h>
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <malloc.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "utilities.h"
 #include "lambda.h"
 
 #define	  HEAD     '^'		/* symbol for head operation */
 #define	  TAIL     '~'		/* symbol for tail operation */
-#define	  SIZE     2000		/* size of local arrays */
+#define	  SIZE     2000		/* initial size of traversal stacks */
 #define	  SMALL    100		/* size of small local arrays */
+#define	  SHARED_TEXT  240	/* longest normal form in the shared memo, + 1 */
+#define	  SHARED_WAYS  8	/* slots probed in the shared memo */
+#define	  OUTPUT   1024		/* initial size of the output buffer */
+#define	  SLACK    8		/* output room kept for single characters */
+#define	  CC_LETTER  1		/* character classes, see get_token() */
+#define	  CC_DIGIT   2
+#define	  CC_BLANK   4
+#define	  FUSED    2		/* L->standard: names from the walk, see standard_form() */
+#define	  SYM_LISTED  1		/* symbol marks: in L->identifiers */
+#define	  SYM_FREE    2		/* occurs free, see collect_free() */
+#define	  SYM_BOUND   4		/* once per enclosing abstraction */
+
+#define	  SYMBOL(L, name)  locate (L, name, sizeof (name) - 1)	/* a literal name */
+
+/*
+ * heap access; with SOA_HEAP the node fields live in separate arrays
+ * (structure of arrays), otherwise in one heap_node record per node.
+ */
+
+#ifdef SOA_HEAP
+#define	  CODE(n)      (L->heap_code[n])
+#define	  OP1(n)       (L->heap_op1[n])
+#define	  OP2(n)       (L->heap_u[n].op2)
+#define	  ALT(n)       (L->heap_u[n].alt)
+#define	  SCOPE(n)     (L->heap_scope[n])
+#else
+#define	  CODE(n)      (L->heap[n].code)
+#define	  OP1(n)       (L->heap[n].op1)
+#define	  OP2(n)       (L->heap[n].u.op2)
+#define	  ALT(n)       (L->heap[n].u.alt)
+#define	  SCOPE(n)     (L->heap[n].scope)
+#endif
+
+/* marks of the garbage collector; see garbage() */
+
+#define	  MARKED(n)    (L->gc_mark[n] == L->gc_epoch)
+#define	  MARK(n)      (L->gc_mark[n] = L->gc_epoch)
+
+/* marks of the not_free(), recurve() and scope() walks; see new_epoch() */
+
+#define	  VISITED(n)   (L->mark[n] == L->epoch)
+#define	  VISIT(n)     (L->mark[n] = L->epoch)
+
+/* states of a free-variable set besides 0..FV_IDS members */
+
+#define	  FV_UNKNOWN   -1		/* not computed since get_node() */
+#define	  FV_BUSY      -2		/* being computed */
+#define	  FV_MANY      (FV_IDS + 1)	/* too many or unknowable: all ids */
 
 /*==================================================================*/
 
 PUBLIC interpreter *initialize_lambda (parmsLambda * Params);
 PUBLIC void free_interpreter (interpreter * Interp);
 PUBLIC char *reduce_lambda (char *in, interpreter * Interp);
+PUBLIC char *reduce_lambda_view (const char *in, size_t length, interpreter * Interp);
 PUBLIC char *reduce_expression (char *in);
+PUBLIC void lambda_default_parameters (parmsLambda * Params);
+PUBLIC interpreter *lambda_open (const parmsLambda * Params);
+PUBLIC char *lambda_reduce_normalized (interpreter * Interp, char *in);
+PUBLIC char *lambda_reduce_view (interpreter * Interp, const char *in, size_t length);
+PUBLIC void lambda_reduce_batch (interpreter * Interp, const char **in, size_t n,
+				 char **out, reduce_status * st);
+PUBLIC void reduce_batch (const char **in, size_t n, char **out, reduce_status * st);
+PUBLIC char *lambda_reduce_packed (interpreter * Interp, const char *in, size_t n,
+				   size_t * out_len, reduce_status * st);
+PUBLIC void lambda_free (void *block);
+PUBLIC void lambda_get_stats (interpreter * Interp, lambda_stats * stats);
+PUBLIC const char *lambda_output (interpreter * Interp, size_t * length);
+PUBLIC uint64_t lambda_canonical_hash (interpreter * Interp, int root);
+PUBLIC uint64_t lambda_normal_form_hash (interpreter * Interp);
+PUBLIC void lambda_reduce_parallel (const parmsLambda * parms, const char **in, size_t n,
+				    char **out, reduce_status * st, int threads);
+PUBLIC char *lambda_reduce_packed_parallel (const parmsLambda * parms, const char *in,
+					    size_t n, size_t * out_len,
+					    reduce_status * st, int threads);
+PUBLIC void lambda_close (interpreter * Interp);
+PUBLIC lambda_corpus *lambda_corpus_open (const char *file);
+PUBLIC int lambda_corpus_next (lambda_corpus * C, const char **program, size_t * length,
+			       size_t * body);
+PUBLIC void lambda_corpus_close (lambda_corpus * C);
 PUBLIC char *standardize (char *expression, interpreter * Interp);
 PUBLIC char *bind_all_free_vars (char *expression, interpreter * Interp);
 PUBLIC int  Free_Variables (char *expression, interpreter * Interp);
-PUBLIC void status (FILE * fp);
-
-PRIVATE int locate (char *name);
-PRIVATE int hash (char *any);
-PRIVATE char get_token (int *n, float *x);
-PRIVATE int r_child (int point);
-PRIVATE int l_child (int point);
-PRIVATE void clear (void);
-PRIVATE int garbage (void);
-PRIVATE int get_node (void);
-PRIVATE void print_expression (int rt);
-PRIVATE boolean print_char (int x, int *count);
-PRIVATE void print_id (int dummy, int point, int *count);
-PRIVATE void make_name (int scpe);
-PRIVATE int pop (int *track, int *top, boolean * more, int *count);
-PRIVATE void parse (int *rt);
-PRIVATE void push (char item, int *top, boolean * ok);
-PRIVATE void add_identifier (int n);
-PRIVATE boolean not_free (int id, int point);
+PUBLIC void status (FILE * fp, interpreter * Interp);
+
+PRIVATE int locate (interpreter * L, const char *name, int length);
+PRIVATE unsigned int symbol_hash (const char *name, int length);
+PRIVATE void grow_symbols (interpreter * L);
+PRIVATE void rehash_symbols (interpreter * L, int slots);
+PRIVATE void forget_symbols (interpreter * L);
+PRIVATE char *reduce_bare (interpreter * Interp, const char *expr);
+struct pool;
+PRIVATE boolean next_item (struct pool *P, int self, size_t * item);
+PRIVATE void *pool_worker (void *arg);
+PRIVATE char get_token (interpreter * L, int *n, float *x);
+PRIVATE size_t scan_run (interpreter * L, int class);
+PRIVATE float fraction (int whole, const char *digit, size_t n);
+PRIVATE int r_child (interpreter * L, int point);
+PRIVATE int l_child (interpreter * L, int point);
+PRIVATE void clear (interpreter * L);
+PRIVATE void allocate_heap (interpreter * L);
+PRIVATE void release_heap (interpreter * L);
+PRIVATE void need_scope (interpreter * L);
+PRIVATE void init_node (interpreter * L, int n);
+PRIVATE void new_epoch (interpreter * L);
+PRIVATE fv_set *free_variables (interpreter * L, int root);
+PRIVATE void fv_combine (interpreter * L, int point);
+PRIVATE boolean fv_lacks (interpreter * L, int point, int id);
+PRIVATE void forget_free_variables (interpreter * L);
+PRIVATE void garbage (interpreter * L);
+PRIVATE void *resize (void *block, size_t size);
+PRIVATE void grow_heap (interpreter * L);
+PRIVATE int get_node (interpreter * L);
+PRIVATE void print_expression (interpreter * L, int rt);
+PRIVATE void print_char (interpreter * L, int x, int *count);
+PRIVATE void print_text (interpreter * L, const char *text, int n, int *count);
+PRIVATE void print_int (interpreter * L, int value, int *count);
+PRIVATE void grow_output (interpreter * L, size_t need);
+PRIVATE void print_id (interpreter * L, int dummy, int point, int *count);
+PRIVATE void print_binder (interpreter * L, int id, int top, int *count);
+PRIVATE void print_bound (interpreter * L, int id, int *count);
+PRIVATE int make_name (interpreter * L, int scpe);
+PRIVATE void taken_suffixes (interpreter * L);
+PRIVATE boolean taken (interpreter * L, int value);
+PRIVATE int pop (interpreter * L, int *track, int *top, boolean * more, boolean * tail,
+		int *count);
+PRIVATE uint64_t canonical_hash (interpreter * L, int root, uint64_t seed);
+PRIVATE uint64_t hash_variable (interpreter * L, int id, int depth, int *n_free);
+PRIVATE uint64_t mix (uint64_t h, uint64_t token);
+PRIVATE void hash_cons (interpreter * L, int root);
+PRIVATE int cons_node (interpreter * L, int node, int code, int op1, int op2);
+PRIVATE boolean memo_probe (interpreter * L, const char *in, size_t length);
+PRIVATE void text_key (const char *in, size_t length, uint64_t * key);
+PRIVATE char *memo_recall (interpreter * L);
+PRIVATE void memo_store (interpreter * L, char *normal_form);
+PRIVATE int memo_find (interpreter * L, uint64_t * key, int *slot);
+PRIVATE void memo_unlink (interpreter * L, int entry);
+PRIVATE void shared_memo_open (int size);
+PRIVATE boolean shared_lookup (interpreter * L, memo_entry * found);
+PRIVATE boolean same_results (const parmsLambda * a, const parmsLambda * b);
+PRIVATE void shared_store (interpreter * L, char *normal_form);
+PRIVATE void parse (interpreter * L, int *rt);
+PRIVATE void push (interpreter * L, char item, int *top, boolean * ok);
+PRIVATE void add_identifier (interpreter * L, int n);
+PRIVATE boolean not_free (interpreter * L, int id, int point);
 PRIVATE int back_up (int *top, boolean * move, int *trace);
-PRIVATE void recurve (int id, int point);
-PRIVATE int reduce (int rt, heap_node * nd);
-PRIVATE void store (int index);
-PRIVATE void go_back (void);
-PRIVATE void alpha (void);
-PRIVATE void beta1 (void);
-PRIVATE void beta2 (void);
-PRIVATE void beta3 (void);
-PRIVATE void beta3p (void);
-PRIVATE void beta4 (void);
-PRIVATE void beta4p (void);
-PRIVATE void gamma0 (void);
-PRIVATE void gamma1 (void);
-PRIVATE void gamma2 (void);
-PRIVATE void arithmetics (int which);
-PRIVATE void rational (int some, int which);
-PRIVATE void relation (int which);
-PRIVATE void racomp (int some, int which, boolean * answer, boolean * done);
-PRIVATE void unary (int which);
-PRIVATE void binary (int which);
-PRIVATE int alpha_standardize (int rt);
+PRIVATE void recurve (interpreter * L, int id, int point);
+PRIVATE int reduce (interpreter * L, int rt);
+PRIVATE void store (interpreter * L, int index);
+PRIVATE void go_back (interpreter * L);
+PRIVATE void alpha (interpreter * L);
+PRIVATE void beta1 (interpreter * L);
+PRIVATE void beta2 (interpreter * L);
+PRIVATE void beta3 (interpreter * L);
+PRIVATE void beta3p (interpreter * L);
+PRIVATE void beta4 (interpreter * L);
+PRIVATE void beta4p (interpreter * L);
+PRIVATE void gamma0 (interpreter * L);
+PRIVATE void gamma1 (interpreter * L);
+PRIVATE void gamma2 (interpreter * L);
+PRIVATE void arithmetics (interpreter * L, int which);
+PRIVATE void rational (interpreter * L, int some, int which);
+PRIVATE void relation (interpreter * L, int which);
+PRIVATE void racomp (interpreter * L, int some, int which, boolean * answer, boolean * done);
+PRIVATE void unary (interpreter * L, int which);
+PRIVATE void binary (interpreter * L, int which);
+PRIVATE int alpha_standardize (interpreter * L, int rt);
 PRIVATE int silent_pop (int *track, int *top, boolean * more);
-PRIVATE void scope (int id, int point, int scope_id);
-PRIVATE int free_vars_list (void);
-PRIVATE void clear_free_vars_list (int n);
-PRIVATE void print_free_vars_list (FILE * fp);
-PRIVATE int str_getc (char *string);
-PRIVATE void strip (char *string, char *string2);
-PRIVATE void err (char *message);
-
-/*==================================================================*/
-
-PRIVATE interpreter *L;
-
-PRIVATE jmp_buf LONGJUMP;
-PRIVATE jmp_buf RECOVER;
+PRIVATE void scope (interpreter * L, int id, int point, int scope_id);
+PRIVATE int resolve_binders (interpreter * L, int rt);
+PRIVATE boolean standard_form (interpreter * L, int rt);
+PRIVATE int id_length (interpreter * L, int id);
+PRIVATE boolean made_name (interpreter * L, int id);
+PRIVATE boolean reads_back (interpreter * L, int id);
+PRIVATE int free_vars_list (interpreter * L, boolean first);
+PRIVATE int collect_free (interpreter * L, int rt, boolean first);
+PRIVATE void print_free_vars_list (interpreter * L, FILE * fp);
+PRIVATE int str_getc (interpreter * L, char *string);
+PRIVATE void err (interpreter * L, char *message);
+PRIVATE int *stack_room (scratch * s, int top);
+PRIVATE size_t corpus_fill (lambda_corpus * C, size_t need);
+PRIVATE size_t corpus_find (lambda_corpus * C, size_t from, char c);
+PRIVATE boolean key_word (const char *text, size_t n, const char *word);
+#ifndef NO_MAIN
+struct block;
+PRIVATE void stream (interpreter * Lambda, lambda_corpus * C, FILE * out);
+PRIVATE void stream_program (interpreter * Lambda, const char *program, size_t length,
+			     struct block *B);
+PRIVATE void put_text (struct block *B, const char *text, size_t n);
+PRIVATE void put_int (struct block *B, int value);
+#endif
 
 /*==================================================================*/
 
@@ -114,23 +251,29 @@ initialize_lambda (parmsLambda * Params)
 {
   register int i;
   interpreter *Interp;
+  interpreter *L;
+  char *c;
 
   Interp = (interpreter *) space (sizeof (interpreter));
 
   Interp->parms = Params;
 
-  Interp->table = (element *) space (sizeof (element) * (Interp->parms->symbol_table_size + 1));
-  for (i = 0; i <= Interp->parms->symbol_table_size; i++)
-    {
-      Interp->table[i].symbol = (char *) space (sizeof (char) * (Interp->parms->name_length + 2));
-      Interp->table[i].key = 0;
-      Interp->table[i].next = 0;
-    }
+  Interp->symbols = Interp->parms->symbol_table_size;
+  Interp->table = (element *) space (sizeof (element) * (Interp->symbols + 1));
+  for (i = 0; i <= Interp->symbols; i++)
+    Interp->table[i].symbol = (char *) space (sizeof (char) * (Interp->parms->name_length + 1));
 
   Interp->stack = (pair *) space (sizeof (pair) * (Interp->parms->stack_size + 1));
   Interp->path = (int *) space (sizeof (int) * (Interp->parms->stack_size + 1));
-  Interp->identifiers = (int *) space (sizeof (int) * (Interp->parms->symbol_table_size + 1));
-  Interp->free_vars = (char **) space (sizeof (char *) * (Interp->parms->symbol_table_size + 1));
+  Interp->track.size = SIZE;
+  Interp->track.item = (int *) space (sizeof (int) * (SIZE + 1));
+  Interp->trace.size = SIZE;
+  Interp->trace.item = (int *) space (sizeof (int) * (SIZE + 1));
+  Interp->names.size = SIZE;
+  Interp->names.item = (int *) space (sizeof (int) * (SIZE + 1));
+  Interp->identifiers = (int *) space (sizeof (int) * (Interp->symbols + 1));
+  Interp->free_vars = (int *) space (sizeof (int) * (Interp->symbols + 1));
+  Interp->symbol_mark = (int *) space (sizeof (int) * (Interp->symbols + 1));
 
   Interp->letters = (char *) space (sizeof (char) * 2 * 28);
   strcpy (Interp->letters, "abcdefghijklmnopqrstuvwxyz$");
@@ -139,25 +282,34 @@ initialize_lambda (parmsLambda * Params)
   Interp->numbers = (char *) space (sizeof (char) * 11);
   strcpy (Interp->numbers, "0123456789");
 
-  Interp->new_name = (char *) space (sizeof (char) * (Interp->parms->name_length + 1));
-  Interp->output_expression = (char *) space (sizeof (char) * (Interp->parms->heap_size + 2));
-  Interp->output_expression_ptr = Interp->output_expression;
+  for (c = Interp->letters; *c; c++)
+    Interp->char_class[(unsigned char) *c] = CC_LETTER;
+  for (c = Interp->numbers; *c; c++)
+    Interp->char_class[(unsigned char) *c] = CC_DIGIT;
+  Interp->char_class[' '] = CC_BLANK;
+  Interp->char_class['\n'] = CC_BLANK;
+
+  Interp->heap_size = Interp->parms->heap_size;
+  Interp->output_size = OUTPUT;
+  if (Interp->parms->max_output > 0 && Interp->parms->max_output < OUTPUT - SLACK)
+    Interp->output_size = Interp->parms->max_output + SLACK + 1;
+  Interp->output_expression = (char *) space (sizeof (char) * Interp->output_size);
 
-  for (i = 1; i <= 97; Interp->group[i++] = 0);
   Interp->fresh = 0;
+  for (i = 16; i < 2 * Interp->symbols; i *= 2);
+  Interp->symbol_slot = (int *) space (sizeof (int) * i);
+  Interp->symbol_mask = i - 1;
 
-  Interp->heap = (heap_node *) space (sizeof (heap_node) * (Interp->parms->heap_size + 1));
+  L = Interp;
 
-  for (i = 1; i <= Interp->parms->heap_size; i++)
-    {
-      Interp->heap[i].code = 0;	/* free nodes will be indirection nodes */
-      Interp->heap[i].op1 = 0;
-      Interp->heap[i].u.op2 = i - 1;
-      Interp->heap[i].marker = FALSE;
-      Interp->heap[i].scope = 0;
-    }
+  allocate_heap (L);
 
-  Interp->_free = Interp->parms->heap_size;
+  Interp->bump = Interp->heap_size + 1;
+  Interp->bump_floor = 1;
+  Interp->sweep = 0;
+  Interp->fresh_marks = FALSE;
+  Interp->collections = 0;
+  Interp->heap_growths = 0;
   Interp->garbage_collected = 0;
 
   Interp->error.output_overflow_hits = 0;
@@ -185,28 +337,38 @@ initialize_lambda (parmsLambda * Params)
   Interp->error.wrong_operator = 0;
   Interp->errors_occurred = 0;
 
-  L = Interp;
-
-  Interp->table[locate (" pred      ")].key = 1;
-  Interp->table[locate (" zero      ")].key = 2;
-  Interp->table[locate (" succ      ")].key = 3;
-  Interp->table[locate (" null      ")].key = 4;
-  Interp->table[locate (" add       ")].key = 5;
-  Interp->table[locate (" sub       ")].key = 6;
-  Interp->table[locate (" mult      ")].key = 7;
-  Interp->table[locate (" div       ")].key = 8;
-  Interp->table[locate (" iota      ")].key = 15;
-  Interp->table[locate (" show      ")].key = 16;
-  Interp->table[locate (" more      ")].key = 17;
-  Interp->table[locate (" not       ")].key = 20;
-  Interp->table[locate (" true      ")].key = 21;
-  Interp->table[locate (" false     ")].key = 22;
-  Interp->table[locate (" and       ")].key = 23;
-  Interp->table[locate (" or        ")].key = 24;
-  Interp->table[locate (" map       ")].key = 25;
-  Interp->table[locate (" append    ")].key = 26;
-
-  L = NULL;
+  Interp->table[SYMBOL (L, "pred")].key = 1;
+  Interp->table[SYMBOL (L, "zero")].key = 2;
+  Interp->table[SYMBOL (L, "succ")].key = 3;
+  Interp->table[SYMBOL (L, "null")].key = 4;
+  Interp->table[SYMBOL (L, "add")].key = 5;
+  Interp->table[SYMBOL (L, "sub")].key = 6;
+  Interp->table[SYMBOL (L, "mult")].key = 7;
+  Interp->table[SYMBOL (L, "div")].key = 8;
+  Interp->table[SYMBOL (L, "iota")].key = 15;
+  Interp->table[SYMBOL (L, "show")].key = 16;
+  Interp->table[SYMBOL (L, "more")].key = 17;
+  Interp->table[SYMBOL (L, "not")].key = 20;
+  Interp->table[SYMBOL (L, "true")].key = 21;
+  Interp->table[SYMBOL (L, "false")].key = 22;
+  Interp->table[SYMBOL (L, "and")].key = 23;
+  Interp->table[SYMBOL (L, "or")].key = 24;
+  Interp->table[SYMBOL (L, "map")].key = 25;
+  Interp->table[SYMBOL (L, "append")].key = 26;
+  SYMBOL (L, "TRUE");		/* produced by relations at run time */
+  SYMBOL (L, "FALSE");
+
+  Interp->reserved = Interp->fresh;	/* built-ins survive forget_symbols() */
+
+  if (Interp->parms->memo_size > 0)
+    {
+      Interp->memo = (memo_entry *) space (sizeof (memo_entry) * Interp->parms->memo_size);
+      for (i = 1; i < 2 * Interp->parms->memo_size; i *= 2);
+      Interp->memo_index = (int *) space (sizeof (int) * i);
+      Interp->memo_mask = i - 1;
+    }
+  if (Interp->parms->shared_memo > 0)
+    shared_memo_open (Interp->parms->shared_memo);
 
   return Interp;
 }
@@ -218,17 +380,33 @@ free_interpreter (interpreter * Interp)
 {
   register int i;
 
-  for (i = 0; i <= Interp->parms->symbol_table_size; i++)
+  for (i = 0; i <= Interp->symbols; i++)
     free (Interp->table[i].symbol);
   free (Interp->table);
+  free (Interp->symbol_slot);
   free (Interp->stack);
   free (Interp->path);
+  free (Interp->track.item);
+  free (Interp->trace.item);
+  free (Interp->names.item);
+  if (Interp->cons)
+    free (Interp->cons);
+  if (Interp->suffix)
+    free (Interp->suffix);
+  if (Interp->memo)
+    {
+      for (i = 0; i < Interp->memo_used; i++)
+	if (Interp->memo[i].normal_form)
+	  free (Interp->memo[i].normal_form);
+      free (Interp->memo);
+      free (Interp->memo_index);
+    }
   free (Interp->identifiers);
   free (Interp->free_vars);
+  free (Interp->symbol_mark);
   free (Interp->numbers);
   free (Interp->letters);
-  free (Interp->new_name);
-  free (Interp->heap);
+  release_heap (Interp);
   free (Interp->output_expression);
   free (Interp);
 }
@@ -243,8 +421,24 @@ free_interpreter (interpreter * Interp)
 PUBLIC char *
 reduce_lambda (char *in, interpreter * Interp)
 {
+  return reduce_lambda_view (in, LAMBDA_NUL, Interp);
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * the same for the length characters at in, which need not be NUL
+ * terminated, e.g. a slice of lambda_corpus; new lines and tabs in
+ * the slice are white space.  LAMBDA_NUL as length reads up to the NUL.
+ */
+
+PUBLIC char *
+reduce_lambda_view (const char *in, size_t length, interpreter * Interp)
+{
+  interpreter *L;
   char *result;
   int rc = 0;
+  boolean evaluated;
   int number;
   int prefix;
   int expr;
@@ -253,35 +447,51 @@ reduce_lambda (char *in, interpreter * Interp)
 
   L = Interp;
   L->busy = 1;
+  L->reducing = FALSE;
+  L->shared = 0;
 
-  clear ();
+  clear (L);
 
-  L->input_expression = in;
-  L->current_expression = in;
+  L->input_expression = (char *) in;
+  L->input_length = length;
+  L->input_end = (length == LAMBDA_NUL) ? strlen (in) : length;
+  L->current_expression = (char *) in;
   L->output_expression[0] = '\0';
+  L->output_length = 0;
   
-  if (setjmp (RECOVER))
+  if (setjmp (L->recover))
     {
       L->output_expression[0] = '\0';
+      L->output_length = 0;
       L->busy = 0;
       return NULL;
     }
   
-  L->peek = str_getc (L->input_expression);
-  body = get_node ();
+  L->peek = str_getc (L, L->input_expression);
+  body = get_node (L);
   L->root = body;
+  evaluated = FALSE;
 
   while (L->peek != '\0')
     {
-      if (get_token (&number, &ratio) == 'a')
+      if (get_token (L, &number, &ratio) == 'a')
 	{
-	  if (strcmp (L->table[number].symbol, " eval      ") == 0)
+	  if (strcmp (L->table[number].symbol, "eval") == 0)
 	    {
-	      parse (&body);
-	      rc = reduce (L->root, L->heap);
+	      evaluated = TRUE;
+	      parse (L, &body);
+	      if (L->parms->hash_cons)
+		hash_cons (L, L->root);
+	      L->reducing = TRUE;
+	      rc = reduce (L, L->root);
+	      L->reducing = FALSE;
 	      if (rc)
 		{
-		  print_expression (L->root);
+		  if (!L->normalize || !standard_form (L, L->root))
+		    {
+		      L->standard = FALSE;
+		      print_expression (L, L->root);
+		    }
 		}
 	      else
 		{
@@ -289,572 +499,1764 @@ reduce_lambda (char *in, interpreter * Interp)
 		  L->error.sum_no_nf_terms++;
 		}
 	    }
-	  else if (strcmp (L->table[number].symbol, " let       ") == 0)
+	  else if (strcmp (L->table[number].symbol, "let") == 0)
 	    {
-	      if (get_token (&number, &ratio) != 'a')
-		err ("Identifier missing from let\n");
+	      if (get_token (L, &number, &ratio) != 'a')
+		err (L, "Identifier missing from let\n");
 	      else
 		{
-		  prefix = get_node ();
-		  L->heap[body].op1 = prefix;
-		  expr = get_node ();
-		  L->heap[body].u.op2 = expr;
-		  L->heap[body].code = 2;
-		  L->heap[prefix].code = 1;
-		  L->heap[prefix].op1 = number;
-		  body = get_node ();
-		  L->heap[prefix].u.op2 = body;
-		  if (get_token (&number, &ratio) != '_')
-		    err ("The _ sign is missing from let\n");
+		  prefix = get_node (L);
+		  OP1 (body) = prefix;
+		  expr = get_node (L);
+		  OP2 (body) = expr;
+		  CODE (body) = 2;
+		  CODE (prefix) = 1;
+		  OP1 (prefix) = number;
+		  body = get_node (L);
+		  OP2 (prefix) = body;
+		  if (get_token (L, &number, &ratio) != '_')
+		    err (L, "The _ sign is missing from let\n");
 		  else
 		    {
-		      parse (&expr);
-		      recurve (L->heap[prefix].op1, expr);
+		      parse (L, &expr);
+		      recurve (L, OP1 (prefix), expr);
+		      forget_free_variables (L);
 		    }
 		}
 	    }
 	}
       else
-	err ("Wrong Command\n");
+	err (L, "Wrong Command\n");
     }
+  if (!evaluated)
+    err (L, "eval is missing\n");
 
   L->busy = 0;
   
   if (L->output_expression[0] == '\0')
     return NULL;
     
-  result = (char *) space (sizeof (char) * (strlen (L->output_expression) + 1));
-  strcpy (result, L->output_expression);
+  result = (char *) space (sizeof (char) * (L->output_length + 1));
+  memcpy (result, L->output_expression, L->output_length + 1);
   return result;
 }
 
 /*==================================================================*/
 
-/* symbol table */
-
-PRIVATE int
-locate (char *name)
+PUBLIC void
+lambda_default_parameters (parmsLambda * Params)
 {
-  int h;
-  int p;
+  Params->heap_size = 4000;	/* size of heap */
+  Params->cycle_limit = 100000;	/* maximum number of cycles */
+  Params->symbol_table_size = 500;	/* initial size of symbol table */
+  Params->stack_size = 2000;	/* stack size */
+  Params->name_length = 10;	/* max length of identifiers */
+  Params->standard_variable = 'x';	/* name of standard variable */
+  Params->error_fp = stdout;	/* error report */
+  Params->free_var_cache = 0;	/* no free-variable cache */
+  Params->de_bruijn = 0;	/* standardize with scope() walks */
+  Params->max_heap_size = 0;	/* the heap does not grow */
+  Params->hash_cons = 0;	/* parse() builds a tree */
+  Params->memo_size = 0;	/* no memo of normal forms */
+  Params->shared_memo = 0;	/* nor a shared one */
+  Params->max_output = 1 << 24;	/* longest printed expression */
+}
 
-  h = hash (name);
-  p = L->group[h];
+/*------------------------------------------------------------------*/
 
-  while (p != 0 && strcmp (L->table[p].symbol, name) != 0)
-    p = L->table[p].next;
+/*
+ * opens an interpreter handle that is meant to be reused across many
+ * calls of lambda_reduce_normalized(); Params is copied (NULL means
+ * defaults), so the caller may discard it.
+ */
 
-  if (p == 0)
-    {				/* allocate new name */
+PUBLIC interpreter *
+lambda_open (const parmsLambda * Params)
+{
+  parmsLambda *own;
 
-      if (L->fresh < L->parms->symbol_table_size)
-	L->fresh++;
-      else
-	{
-	  L->error.symbol_table_overflow = TRUE;
-	  L->error.symbol_table_overflow_hits++;
-	  err ("Symbol Table Overflow.\n");
-	}
-      p = L->fresh;
-      strcpy (L->table[p].symbol, name);
-      L->table[p].key = 0;
-      L->table[p].next = L->group[h];
+  own = (parmsLambda *) space (sizeof (parmsLambda));
+  if (Params)
+    *own = *Params;
+  else
+    lambda_default_parameters (own);
 
-      L->group[h] = p;
-    }
-  return p;
+  return initialize_lambda (own);
 }
 
 /*------------------------------------------------------------------*/
 
-PRIVATE int
-hash (char *any)
+/*
+ * reduces in, standardizes the normal form and binds its free variables;
+ * this is what reduce_expression() does, but on a persistent handle.
+ * The result belongs to the handle and stays valid until the next call
+ * or lambda_close(); NULL if no normal form was achieved.
+ * reductions and cycles refer to the reduction, not the standardization.
+ */
+
+PUBLIC char *
+lambda_reduce_normalized (interpreter * Interp, char *in)
 {
-  return (any[1] + any[2]) % 97 + 1;
+  return lambda_reduce_view (Interp, in, LAMBDA_NUL);
 }
 
-/*==================================================================*/
-
-PRIVATE char
-get_token (int *n, float *x)
-{
-  char c;
-  int i;
-  int j;
-  int location;
-  char str[SMALL];
-  float place;
+/*------------------------------------------------------------------*/
 
-  *n = 0;
-  str[0] = ' ';
+/* the same for a view of length characters, see reduce_lambda_view() */
 
-  /* skip consecutive blanks, new line chars, and markers */
+PUBLIC char *
+lambda_reduce_view (interpreter * Interp, const char *in, size_t length)
+{
+  char *reduced;
+  char *standard;
+  char *bound;
+  int reductions;
+  int cycles;
+  int cycle_limit;
+  int space_limit;
 
-  while (((L->peek == ' ') || (L->peek == '\n'))
-	 && !(L->peek == '\0'))
-    L->peek = str_getc (L->input_expression);
+  if (Interp->normal_form)
+    {
+      free (Interp->normal_form);
+      Interp->normal_form = NULL;
+    }
 
-  if (strchr (L->letters, L->peek) != NULL)
-    {				/* identifier token */
-      i = 1;
-      while ((strchr (L->letters, L->peek) != NULL)
-	     || (strchr (L->numbers, L->peek) != NULL))
-	{
-	  str[i++] = L->peek;
-	  L->peek = str_getc (L->input_expression);
-	}
-      for (j = i; j <= L->parms->name_length; str[j++] = ' ');
-      str[L->parms->name_length + 1] = '\0';
-      location = locate (str);
-      c = 'a';
-      *n = location;
-    }				/* end of identifier token */
-  else if (strchr (L->numbers, L->peek) != NULL)
-    {				/* numeric token */
-      c = 'i';			/* integer */
-      while (strchr (L->numbers, L->peek) != NULL)
-	{
-	  *n = 10 * (*n) + (L->peek - '0');
-	  L->peek = str_getc (L->input_expression);
-	}
-      if (L->peek == '.')
-	{			/* real */
-	  c = 'r';
-	  L->peek = str_getc (L->input_expression);
-	  *x = *n;
-	  place = 1.;
-	  while (strchr (L->numbers, L->peek) != NULL)
-	    {
-	      place /= 10.;
-	      *x = (*x) + (L->peek - '0') * place;
-	      L->peek = str_getc (L->input_expression);
-	    }
-	}
-    }				/* end of numeric token */
+  forget_symbols (Interp);	/* keep the symbol table from filling up */
+  Interp->n_free_vars = 0;
+
+  Interp->memo_answer = NULL;
+  Interp->memo_keyed = FALSE;
+  if ((Interp->memo != NULL || Interp->parms->shared_memo > 0)
+      && memo_probe (Interp, in, length))
+    return memo_recall (Interp);
+
+  Interp->normalize = TRUE;
+  reduced = reduce_lambda_view (in, length, Interp);
+  Interp->normalize = FALSE;
+  Interp->hash = reduced ? canonical_hash (Interp, Interp->root, 0) : 0;
+  reductions = Interp->reductions;
+  cycles = Interp->cycles;
+  cycle_limit = Interp->error.cycle_limit;
+  space_limit = Interp->error.space_limit;
+
+  if (reduced)
+    Interp->status = REDUCE_NORMAL_FORM;
+  else if (cycle_limit)
+    Interp->status = REDUCE_CYCLE_LIMIT;
+  else if (space_limit)
+    Interp->status = REDUCE_SPACE_LIMIT;
+  else if (Interp->error_number && !Interp->reducing && !Interp->error.output_overflow)
+    Interp->status = REDUCE_PARSE_ERROR;
   else
-    {				/* other token */
-      c = L->peek;
-      L->peek = str_getc (L->input_expression);
-    }
+    Interp->status = REDUCE_ERROR;
 
-  if (c == '<')
+  if (reduced && Interp->standard == FUSED)
+    standard = reduced;		/* printed as standard_form() */
+  else
     {
-      if (L->peek == '=')
-	{
-	  L->peek = str_getc (L->input_expression);
-	  *n = 3;
-	}
-      else if (L->peek == '>')
+      standard = standardize (reduced, Interp);
+      if (standard && Interp->n_free_vars > 0)
 	{
-	  L->peek = str_getc (L->input_expression);
-	  *n = 5;
+	  bound = bind_all_free_vars (standard, Interp);
+	  free (standard);
+	  standard = standardize (bound, Interp);
+	  if (bound)
+	    free (bound);
 	}
-      else
-	*n = 1;
+      if (reduced)
+	free (reduced);
     }
-  else if (c == '>')
+  if (!standard && Interp->status == REDUCE_NORMAL_FORM)
+    {				/* the normal form is too big to parse back */
+      space_limit = Interp->error.space_limit;
+      Interp->status = space_limit ? REDUCE_SPACE_LIMIT : REDUCE_ERROR;
+    }
+  if (!standard)
+    Interp->hash = 0;
+
+  Interp->reductions = reductions;
+  Interp->cycles = cycles;
+  Interp->error.cycle_limit = cycle_limit;
+  Interp->error.space_limit = space_limit;
+
+  if (Interp->memo_keyed
+      && (Interp->status == REDUCE_NORMAL_FORM || Interp->status == REDUCE_CYCLE_LIMIT))
     {
-      if (L->peek == '=')
-	{
-	  L->peek = str_getc (L->input_expression);
-	  *n = 4;
-	}
-      else
-	*n = 2;
+      if (Interp->memo)
+	memo_store (Interp, standard);
+      if (Interp->parms->shared_memo > 0)
+	shared_store (Interp, standard);
     }
-  return c;
+
+  Interp->normal_form = standard;
+  return standard;
 }
 
-/*==================================================================*/
+/*------------------------------------------------------------------*/
 
-PRIVATE int
-r_child (int point)
+/* 
+ * reduces the bare expression expr (no "eval", no ";") through
+ * lambda_reduce_normalized(); the program text is assembled in a buffer
+ * owned by the handle.
+ */
+
+PRIVATE char *
+reduce_bare (interpreter * Interp, const char *expr)
 {
-  register int child;
+  int len;
 
-  child = L->heap[point].u.op2;
-  while (L->heap[child].code == 0)
-    child = L->heap[child].u.op2;
-  L->heap[point].u.op2 = child;
+  len = strlen (expr) + 7;	/* "eval " + expr + ";" */
+  if (len > Interp->program_size)
+    {
+      free (Interp->program);
+      Interp->program_size = 2 * len;
+      Interp->program = (char *) space (sizeof (char) * (Interp->program_size + 1));
+    }
+  strcpy (Interp->program, "eval ");
+  strcat (Interp->program, expr);
+  strcat (Interp->program, ";");
 
-  return child;
+  return lambda_reduce_normalized (Interp, Interp->program);
 }
 
-/*==================================================================*/
+/*------------------------------------------------------------------*/
 
-PRIVATE int
-l_child (int point)
+/*
+ * reduces the n bare expressions in[] one after the other;
+ * out[i] receives a copy of the normalized result (NULL on failure)
+ * that the caller frees, st[i] tells how the reduction ended.
+ */
+
+PUBLIC void
+lambda_reduce_batch (interpreter * Interp, const char **in, size_t n,
+		     char **out, reduce_status * st)
 {
-  register int child;
+  size_t i;
+  char *normal_form;
+
+  for (i = 0; i < n; i++)
+    {
+      normal_form = reduce_bare (Interp, in[i]);
+      st[i] = Interp->status;
+      if (normal_form)
+	{
+	  out[i] = (char *) space (sizeof (char) * (strlen (normal_form) + 1));
+	  strcpy (out[i], normal_form);
+	}
+      else
+	out[i] = NULL;
+    }
+}
 
-  child = L->heap[point].op1;
-  while (L->heap[child].code == 0)
-    child = L->heap[child].u.op2;
-  L->heap[point].op1 = child;
+/*------------------------------------------------------------------*/
 
-  return child;
+/* lambda_reduce_batch() on a default interpreter */
+
+PUBLIC void
+reduce_batch (const char **in, size_t n, char **out, reduce_status * st)
+{
+  interpreter *Lambda;
+
+  Lambda = lambda_open (NULL);
+  lambda_reduce_batch (Lambda, in, n, out, st);
+  lambda_close (Lambda);
 }
 
-/*==================================================================*/
+/*------------------------------------------------------------------*/
 
-/* initialization of the heap */
+/*
+ * batch reduction over packed buffers, for foreign callers: in holds
+ * n NUL-terminated expressions back to back; the result is a single
+ * buffer of n NUL-terminated normal forms in the same order (empty
+ * string on failure), *out_len bytes long, released with lambda_free().
+ */
 
-PRIVATE void
-clear (void)
+PUBLIC char *
+lambda_reduce_packed (interpreter * Interp, const char *in, size_t n,
+		      size_t * out_len, reduce_status * st)
 {
-  int begin;
+  char *out;
+  char *normal_form;
+  size_t size;
+  size_t len;
+  size_t used;
+  size_t i;
+
+  size = 256;
+  used = 0;
+  out = (char *) space (sizeof (char) * size);
+
+  for (i = 0; i < n; i++)
+    {
+      normal_form = reduce_bare (Interp, in);
+      in += strlen (in) + 1;
+      st[i] = Interp->status;
 
-  L->heap[0].code = 12;		/* NIL code */
-  L->heap[0].marker = TRUE;	/* NIL remains marked */
-  L->char_count = 0;		/* reset str_getc() char_count */
-  L->reductions = 0;		/* reset reduction counter */
-  L->cycles = 0;		/* reset cycle counter */
-  L->standard = FALSE;
-  L->n_identifiers = 0;
-  L->error_number = 0;
-  L->error.cycle_limit = 0;	/* reset step limit flag */
-  L->error.space_limit = 0;	/* reset space limit flag */
-  L->error.output_overflow = 0;	/* print expression overflow flag */
-  L->error.symbol_table_overflow = 0;	/* symbol table overflow flag */
-  L->error.not_free_overflow = 0;	/* not_free() overflow flag */
-  L->error.no_nf_term = 0;
+      len = normal_form ? strlen (normal_form) : 0;
+      if (used + len + 1 > size)
+	{
+	  while (used + len + 1 > size)
+	    size *= 2;
+	  out = (char *) realloc (out, sizeof (char) * size);
+	  if (out == NULL)
+	    nrerror ("lambda_reduce_packed: allocation failure");
+	}
+      if (len)
+	memcpy (out + used, normal_form, len);
+      out[used + len] = '\0';
+      used += len + 1;
+    }
 
-  L->output_expression = L->output_expression_ptr;
+  *out_len = used;
+  return out;
+}
 
-  /* 
-   * if the previous call to lambda did not trigger the garbage collector
-   * then we clean up only the used part,
-   * else we can't do that efficiently (used blocks may be scattered around).
-   */
+/*------------------------------------------------------------------*/
 
-  if (!L->garbage_collected)
-    begin = L->_free;
-  else
-    begin = 1;
+PUBLIC void
+lambda_free (void *block)
+{
+  free (block);
+}
 
-  {
-    register int i;		/* very important here: speed! */
+/*------------------------------------------------------------------*/
 
-    for (i = begin; i <= L->parms->heap_size; i++)
-      {
-	L->heap[i].code = 0;	/* free nodes will be indirection nodes */
-	L->heap[i].op1 = 0;
-	L->heap[i].u.op2 = i - 1;
-	L->heap[i].marker = FALSE;
-	L->heap[i].scope = 0;
-      }
-  }
+/* counters of the last reduction and of the handle's lifetime */
 
-  L->_free = L->parms->heap_size;
-  L->garbage_collected = 0;
+PUBLIC void
+lambda_get_stats (interpreter * Interp, lambda_stats * stats)
+{
+  stats->reductions = Interp->reductions;
+  stats->cycles = Interp->cycles;
+  stats->heap_size = Interp->heap_size;
+  stats->collections = Interp->collections;
+  stats->heap_growths = Interp->heap_growths;
+  stats->cycle_limit_hits = Interp->error.cycle_limit_hits;
+  stats->space_limit_hits = Interp->error.space_limit_hits;
+  stats->shared = Interp->shared;
+  stats->memo_hits = Interp->memo_hits;
+  stats->memo_misses = Interp->memo_misses;
+  stats->memo_evictions = Interp->memo_evictions;
+  stats->memo_shared_hits = Interp->memo_shared_hits;
 }
 
-/*==================================================================*/
+/*------------------------------------------------------------------*/
 
-PRIVATE int
-garbage (void)
+/*
+ * the expression printed last, in place: reduce_lambda() returns a copy
+ * of the same text.  It stays valid until the handle is used again.
+ */
+
+PUBLIC const char *
+lambda_output (interpreter * Interp, size_t * length)
 {
-  static int track[SIZE + 1];
-  int code;
-  int point;
-  int top;
-  int i;
-  int stop;
-  boolean more;
+  *length = Interp->output_length;
+  return Interp->output_expression;
+}
 
-  L->garbage_collected = 1;	/* set clean-up flag for clear() on next round */
+/*------------------------------------------------------------------*/
 
-  more = TRUE;
-  top = 0;
-  stop = 0;
-  point = L->root;
+/*
+ * alpha-invariant hash of the graph at root, e.g. Interp->root after
+ * reduce_lambda(); alpha-equivalent terms hash alike, without the
+ * detour through standardize().  See canonical_hash().
+ */
 
-  while (more)
-    {				/* marking phase */
-      code = L->heap[point].code;
-      if (code > 3)
-	L->heap[point].marker = TRUE;
-      if (L->heap[point].marker == TRUE)
-	{			/* may be NIL */
-	  if (top > 0)
-	    point = track[top--];
-	  else
-	    more = FALSE;
-	}
-      else
-	{
-	  L->heap[point].marker = TRUE;
-	  if ((code == 2) || (code == 3))
-	    {
-	      if (top < SIZE)
-		track[++top] = r_child (point);
-	      else
-		{
-		  err ("garbage track overflow.\n");
-		  more = FALSE;
-		  stop = 1;
-		}
-	      point = l_child (point);
-	    }
-	  else
-	    point = r_child (point);	/* code must be less than 2 */
-	}
-    }				/* end of marking phase */
+PUBLIC uint64_t
+lambda_canonical_hash (interpreter * Interp, int root)
+{
+  return canonical_hash (Interp, root, 0);
+}
 
-  for (i = 1; i <= L->parms->heap_size; i++)
-    {
-      if (L->heap[i].marker)
-	L->heap[i].marker = FALSE;
-      else
-	{
-	  L->heap[i].code = 0;
-	  L->heap[i].op1 = 0;
-	  L->heap[i].u.op2 = L->_free;
-	  L->_free = i;
-	}
-    }
-  return stop;
+/*------------------------------------------------------------------*/
+
+/*
+ * the canonical hash of the normal form returned by the last
+ * lambda_reduce_normalized(), 0 if there was none.
+ */
+
+PUBLIC uint64_t
+lambda_normal_form_hash (interpreter * Interp)
+{
+  return Interp->hash;
 }
 
 /*==================================================================*/
 
-PRIVATE int
-get_node (void)
+/*
+ * memo of normal forms, parms->memo_size entries per handle, for
+ * lambda_reduce_normalized().  The key is a 128-bit hash of the program
+ * text.  Alpha-equivalent inputs are not merged: which names are free,
+ * and where a name first occurs, decide the printed normal form.
+ * Normal forms and cycle limits are remembered; space limits depend on
+ * the heap and are not.  Entries are replaced by the CLOCK rule.  With
+ * parms->shared_memo, results are also kept in a memo shared by all
+ * handles of the process.
+ */
+
+/*
+ * called before the program is parsed; TRUE if a memo answers it,
+ * otherwise remembers the key for memo_store().
+ */
+
+PRIVATE boolean
+memo_probe (interpreter * L, const char *in, size_t length)
 {
-  int gn;
+  int slot;
+  int i;
 
-  if (L->_free == 0)		/* corrected 08/08/92  WF   */
-    if (garbage () == 1)
-      {
-	err ("garbage collection error.\n");
-	return FALSE;
-      }
-  if (L->_free == 0)
+  text_key (in, (length == LAMBDA_NUL) ? strlen (in) : length, L->memo_key);
+  L->memo_keyed = TRUE;
+
+  if (L->memo && (i = memo_find (L, L->memo_key, &slot)) >= 0)
     {
-      L->iterate = FALSE;
-      if (!L->error.space_limit)
-	L->error.space_limit_hits += 1;
-      L->error.space_limit = TRUE;
-      err ("ran out of space.\n");
-      return FALSE;
+      L->memo_hits++;
+      L->memo[i].referenced = TRUE;
+      L->memo_answer = L->memo + i;
+      return TRUE;
     }
-  else
+  if (L->parms->shared_memo > 0 && shared_lookup (L, &L->shared_answer))
     {
-      gn = L->_free;		/* node has code = 0 and op1 = 0 */
-      L->_free = L->heap[L->_free].u.op2;
-      return gn;
+      L->memo_shared_hits++;
+      L->memo_answer = &L->shared_answer;
+      return TRUE;
     }
+  L->memo_misses++;
+  return FALSE;
+}
+
+/*------------------------------------------------------------------*/
+
+/* two independent 64-bit hashes of the length characters at in */
+
+PRIVATE void
+text_key (const char *in, size_t length, uint64_t * key)
+{
+  uint64_t word;
+  size_t i;
+
+  key[0] = length;
+  key[1] = length ^ 0x3c6ef372fe94f82bULL;
+  for (i = 0; i + 8 <= length; i += 8)
+    {
+      memcpy (&word, in + i, 8);
+      key[0] = mix (key[0], word);
+      key[1] = mix (key[1], word ^ 0xa54ff53a5f1d36f1ULL);
+    }
+  word = 0;
+  memcpy (&word, in + i, length - i);
+  key[0] = mix (mix (key[0], word), 0x510e527fade682d1ULL);
+  key[1] = mix (mix (key[1], word ^ 0xa54ff53a5f1d36f1ULL), 0x9b05688c2b3e6c1fULL);
+}
+
+/*------------------------------------------------------------------*/
+
+/* completes lambda_reduce_normalized() from the entry memo_probe() found */
+
+PRIVATE char *
+memo_recall (interpreter * L)
+{
+  memo_entry *entry;
+
+  entry = L->memo_answer;
+  L->output_expression[0] = '\0';
+  L->output_length = 0;
+  L->shared = 0;
+  L->status = entry->status;
+  L->reductions = entry->reductions;
+  L->cycles = entry->cycles;
+  L->hash = entry->hash;
+  L->error.cycle_limit = (entry->status == REDUCE_CYCLE_LIMIT);
+  L->error.space_limit = 0;
+  if (entry == &L->shared_answer)
+    {				/* a copy made by shared_lookup() */
+      L->normal_form = entry->normal_form;
+      if (L->memo)
+	memo_store (L, L->normal_form);
+    }
+  else if (entry->normal_form)
+    {
+      L->normal_form = (char *) space (sizeof (char) * (strlen (entry->normal_form) + 1));
+      strcpy (L->normal_form, entry->normal_form);
+    }
+  return L->normal_form;
+}
+
+/*------------------------------------------------------------------*/
+
+PRIVATE void
+memo_store (interpreter * L, char *normal_form)
+{
+  memo_entry *entry;
+  int slot;
+  int i;
+
+  if (L->memo_used < L->parms->memo_size)
+    i = L->memo_used++;
+  else
+    {
+      while (L->memo[L->memo_hand].referenced)
+	{
+	  L->memo[L->memo_hand].referenced = FALSE;
+	  L->memo_hand = (L->memo_hand + 1) % L->memo_used;
+	}
+      i = L->memo_hand;
+      L->memo_hand = (L->memo_hand + 1) % L->memo_used;
+      memo_unlink (L, i);
+      if (L->memo[i].normal_form)
+	free (L->memo[i].normal_form);
+      L->memo_evictions++;
+    }
+
+  entry = L->memo + i;
+  entry->key[0] = L->memo_key[0];
+  entry->key[1] = L->memo_key[1];
+  entry->hash = L->hash;
+  entry->status = L->status;
+  entry->reductions = L->reductions;
+  entry->cycles = L->cycles;
+  entry->referenced = FALSE;
+  entry->normal_form = NULL;
+  if (normal_form)
+    {
+      entry->normal_form = (char *) space (sizeof (char) * (strlen (normal_form) + 1));
+      strcpy (entry->normal_form, normal_form);
+    }
+
+  memo_find (L, entry->key, &slot);	/* stops at a free slot */
+  L->memo_index[slot] = i + 1;
+}
+
+/*------------------------------------------------------------------*/
+
+/* the entry with key, or -1; *slot is where the search of the index ended */
+
+PRIVATE int
+memo_find (interpreter * L, uint64_t * key, int *slot)
+{
+  memo_entry *entry;
+  int j;
+
+  for (j = (int) (key[0] & L->memo_mask); L->memo_index[j]; j = (j + 1) & L->memo_mask)
+    {
+      entry = L->memo + L->memo_index[j] - 1;
+      if (entry->key[0] == key[0] && entry->key[1] == key[1])
+	{
+	  *slot = j;
+	  return L->memo_index[j] - 1;
+	}
+    }
+  *slot = j;
+  return -1;
+}
+
+/*------------------------------------------------------------------*/
+
+/* removes an entry from the index, closing the gap behind it */
+
+PRIVATE void
+memo_unlink (interpreter * L, int entry)
+{
+  int hole;
+  int j;
+  int home;
+
+  memo_find (L, L->memo[entry].key, &hole);
+  for (j = (hole + 1) & L->memo_mask; L->memo_index[j]; j = (j + 1) & L->memo_mask)
+    {
+      home = (int) (L->memo[L->memo_index[j] - 1].key[0] & L->memo_mask);
+      if (((j - home) & L->memo_mask) >= ((j - hole) & L->memo_mask))
+	{			/* may move back into the hole */
+	  L->memo_index[hole] = L->memo_index[j];
+	  hole = j;
+	}
+    }
+  L->memo_index[hole] = 0;
+}
+
+/*==================================================================*/
+
+/*
+ * the shared memo: one open-addressed table of SHARED_WAYS-way buckets
+ * for the whole process, created by the first handle that asks for it.
+ * Each slot carries a version that is odd while a writer fills it.
+ * Readers copy a slot and keep the copy only if the version was even
+ * and did not change meanwhile, so a lookup never waits.  A writer
+ * claims a slot by compare-and-swap on the version and gives up if
+ * another writer holds it.  Normal forms of SHARED_TEXT characters or
+ * more are not shared, and a slot answers only handles whose parameters
+ * give the same results, see same_results().
+ */
+
+typedef struct shared_slot
+  {
+    atomic_uint version;	/* 0: never written */
+    uint64_t key[2];
+    uint64_t hash;
+    int status;
+    int reductions;
+    int cycles;
+    parmsLambda parms;		/* of the handle that stored it */
+    int length;			/* of text, -1 without a normal form */
+    char text[SHARED_TEXT];
+  }
+shared_slot;
+
+static shared_slot *shared_memo = NULL;
+static unsigned int shared_mask;
+static pthread_mutex_t shared_memo_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*------------------------------------------------------------------*/
+
+/* the first call sizes the table for good; it lives as long as the process */
+
+PRIVATE void
+shared_memo_open (int size)
+{
+  unsigned int n;
+
+  pthread_mutex_lock (&shared_memo_lock);
+  if (shared_memo == NULL)
+    {
+      for (n = SHARED_WAYS; n < (unsigned int) size; n *= 2);
+      shared_memo = (shared_slot *) space (sizeof (shared_slot) * n);
+      shared_mask = n - 1;
+    }
+  pthread_mutex_unlock (&shared_memo_lock);
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * TRUE if memo_key is in the shared memo for the parameters of L; found
+ * then owns a copy of the normal form.
+ */
+
+PRIVATE boolean
+shared_lookup (interpreter * L, memo_entry * found)
+{
+  shared_slot *slot;
+  shared_slot copy;
+  uint64_t *key;
+  unsigned int version;
+  unsigned int i;
+
+  key = L->memo_key;
+  for (i = 0; i < SHARED_WAYS; i++)
+    {
+      slot = shared_memo + ((key[0] + i) & shared_mask);
+      version = atomic_load_explicit (&slot->version, memory_order_acquire);
+      if (version == 0 || (version & 1))
+	continue;
+      if (slot->key[0] != key[0] || slot->key[1] != key[1])
+	continue;
+      memcpy (&copy.key, &slot->key, sizeof (shared_slot) - offsetof (shared_slot, key));
+      atomic_thread_fence (memory_order_acquire);
+      if (atomic_load_explicit (&slot->version, memory_order_relaxed) != version)
+	return FALSE;		/* being rewritten: count as a miss */
+      if (copy.key[0] != key[0] || copy.key[1] != key[1])
+	continue;
+      if (!same_results (&copy.parms, L->parms))
+	continue;
+
+      found->hash = copy.hash;
+      found->status = (reduce_status) copy.status;
+      found->reductions = copy.reductions;
+      found->cycles = copy.cycles;
+      found->normal_form = NULL;
+      if (copy.length >= 0)
+	{
+	  found->normal_form = (char *) space (sizeof (char) * (copy.length + 1));
+	  memcpy (found->normal_form, copy.text, copy.length);
+	  found->normal_form[copy.length] = '\0';
+	}
+      return TRUE;
+    }
+  return FALSE;
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * whether handles with parameters a and b reduce every program to the
+ * same text and status; error_fp and the memo sizes do not matter.
+ */
+
+PRIVATE boolean
+same_results (const parmsLambda * a, const parmsLambda * b)
+{
+  return a->heap_size == b->heap_size && a->max_heap_size == b->max_heap_size
+    && a->cycle_limit == b->cycle_limit && a->stack_size == b->stack_size
+    && a->symbol_table_size == b->symbol_table_size && a->name_length == b->name_length
+    && a->standard_variable == b->standard_variable && a->max_output == b->max_output
+    && a->free_var_cache == b->free_var_cache && a->de_bruijn == b->de_bruijn
+    && a->hash_cons == b->hash_cons;
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * enters the current result; a free slot of the bucket is taken first,
+ * else the one key[1] picks.
+ */
+
+PRIVATE void
+shared_store (interpreter * L, char *normal_form)
+{
+  shared_slot *slot;
+  unsigned int version;
+  unsigned int i;
+  int length;
+
+  length = normal_form ? (int) strlen (normal_form) : -1;
+  if (length >= SHARED_TEXT)
+    return;
+
+  slot = shared_memo + ((L->memo_key[0] + L->memo_key[1] % SHARED_WAYS) & shared_mask);
+  for (i = 0; i < SHARED_WAYS; i++)
+    if (atomic_load_explicit (&shared_memo[(L->memo_key[0] + i) & shared_mask].version,
+			      memory_order_relaxed) == 0)
+      {
+	slot = shared_memo + ((L->memo_key[0] + i) & shared_mask);
+	break;
+      }
+
+  version = atomic_load_explicit (&slot->version, memory_order_relaxed);
+  if ((version & 1)
+      || !atomic_compare_exchange_strong_explicit (&slot->version, &version, version + 1,
+						   memory_order_acquire, memory_order_relaxed))
+    return;			/* another writer has it */
+  atomic_thread_fence (memory_order_release);
+
+  slot->key[0] = L->memo_key[0];
+  slot->key[1] = L->memo_key[1];
+  slot->hash = L->hash;
+  slot->status = L->status;
+  slot->reductions = L->reductions;
+  slot->cycles = L->cycles;
+  slot->parms = *L->parms;
+  slot->length = length;
+  if (length > 0)
+    memcpy (slot->text, normal_form, length);
+
+  atomic_store_explicit (&slot->version, version + 2, memory_order_release);
+}
+
+/*==================================================================*/
+
+/*
+ * parallel batches: one interpreter per worker thread.  Each worker
+ * owns a contiguous range [front, back) of the input; it takes items
+ * from the front of its own range and, once that is empty, steals the
+ * back half of the largest range left.  Every item is reduced on a
+ * freshly cleared heap, so the result does not depend on which worker
+ * picked it up.
+ */
+
+struct deque
+  {
+    pthread_mutex_t lock;
+    size_t front;
+    size_t back;
+  };
+
+struct pool
+  {
+    const parmsLambda *parms;
+    const char **in;
+    char **out;
+    reduce_status *st;
+    struct deque *queue;
+    int workers;
+  };
+
+struct worker
+  {
+    struct pool *pool;
+    int self;
+  };
+
+/*------------------------------------------------------------------*/
+
+PRIVATE boolean
+next_item (struct pool *P, int self, size_t * item)
+{
+  struct deque *own;
+  struct deque *victim;
+  size_t most;
+  size_t left;
+  size_t half;
+  int i;
+
+  own = &P->queue[self];
+  for (;;)
+    {
+      pthread_mutex_lock (&own->lock);
+      if (own->front < own->back)
+	{
+	  *item = own->front++;
+	  pthread_mutex_unlock (&own->lock);
+	  return TRUE;
+	}
+      pthread_mutex_unlock (&own->lock);
+
+      victim = NULL;		/* the choice is re-checked under its lock */
+      most = 0;
+      for (i = 0; i < P->workers; i++)
+	{
+	  if (i == self)
+	    continue;
+	  pthread_mutex_lock (&P->queue[i].lock);
+	  left = P->queue[i].back - P->queue[i].front;
+	  pthread_mutex_unlock (&P->queue[i].lock);
+	  if (left > most)
+	    {
+	      most = left;
+	      victim = &P->queue[i];
+	    }
+	}
+      if (victim == NULL)
+	return FALSE;
+
+      pthread_mutex_lock (&victim->lock);
+      left = victim->back - victim->front;
+      if (left == 0)
+	{
+	  pthread_mutex_unlock (&victim->lock);
+	  continue;
+	}
+      half = (left + 1) / 2;
+      victim->back -= half;
+      pthread_mutex_lock (&own->lock);
+      own->front = victim->back;
+      own->back = victim->back + half;
+      pthread_mutex_unlock (&own->lock);
+      pthread_mutex_unlock (&victim->lock);
+    }
+}
+
+/*------------------------------------------------------------------*/
+
+PRIVATE void *
+pool_worker (void *arg)
+{
+  struct worker *W;
+  struct pool *P;
+  interpreter *Lambda;
+  char *normal_form;
+  size_t i;
+
+  W = (struct worker *) arg;
+  P = W->pool;
+  Lambda = lambda_open (P->parms);
+
+  while (next_item (P, W->self, &i))
+    {
+      normal_form = reduce_bare (Lambda, P->in[i]);
+      P->st[i] = Lambda->status;
+      if (normal_form)
+	{
+	  P->out[i] = (char *) space (sizeof (char) * (strlen (normal_form) + 1));
+	  strcpy (P->out[i], normal_form);
+	}
+      else
+	P->out[i] = NULL;
+    }
+
+  lambda_close (Lambda);
+  return NULL;
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * lambda_reduce_batch() spread over threads workers, each with its own
+ * interpreter built from parms (NULL for the defaults); threads <= 0
+ * means one per online processor.  Results are in input order.
+ */
+
+PUBLIC void
+lambda_reduce_parallel (const parmsLambda * parms, const char **in, size_t n,
+			char **out, reduce_status * st, int threads)
+{
+  struct pool P;
+  struct worker *W;
+  pthread_t *thread;
+  size_t chunk;
+  int i;
+
+  if (threads <= 0)
+    threads = (int) sysconf (_SC_NPROCESSORS_ONLN);
+  if (threads < 1)
+    threads = 1;
+  if ((size_t) threads > n)
+    threads = n ? (int) n : 1;
+
+  P.parms = parms;
+  P.in = in;
+  P.out = out;
+  P.st = st;
+  P.workers = threads;
+  P.queue = (struct deque *) space (sizeof (struct deque) * threads);
+  W = (struct worker *) space (sizeof (struct worker) * threads);
+  thread = (pthread_t *) space (sizeof (pthread_t) * threads);
+
+  chunk = n / threads;
+  for (i = 0; i < threads; i++)
+    {
+      pthread_mutex_init (&P.queue[i].lock, NULL);
+      P.queue[i].front = i * chunk;
+      P.queue[i].back = (i == threads - 1) ? n : (i + 1) * chunk;
+      W[i].pool = &P;
+      W[i].self = i;
+    }
+
+  for (i = 1; i < threads; i++)
+    if (pthread_create (&thread[i], NULL, pool_worker, &W[i]))
+      nrerror ("lambda_reduce_parallel: cannot create thread");
+  pool_worker (&W[0]);
+  for (i = 1; i < threads; i++)
+    pthread_join (thread[i], NULL);
+
+  for (i = 0; i < threads; i++)
+    pthread_mutex_destroy (&P.queue[i].lock);
+  free (thread);
+  free (W);
+  free (P.queue);
+}
+
+/*------------------------------------------------------------------*/
+
+/* lambda_reduce_parallel() over packed buffers, as lambda_reduce_packed() */
+
+PUBLIC char *
+lambda_reduce_packed_parallel (const parmsLambda * parms, const char *in, size_t n,
+			       size_t * out_len, reduce_status * st, int threads)
+{
+  const char **item;
+  char **result;
+  char *out;
+  size_t used;
+  size_t len;
+  size_t i;
+
+  item = (const char **) space (sizeof (char *) * (n + 1));
+  result = (char **) space (sizeof (char *) * (n + 1));
+  for (i = 0; i < n; i++)
+    {
+      item[i] = in;
+      in += strlen (in) + 1;
+    }
+
+  lambda_reduce_parallel (parms, item, n, result, st, threads);
+
+  used = 0;
+  for (i = 0; i < n; i++)
+    used += (result[i] ? strlen (result[i]) : 0) + 1;
+  out = (char *) space (sizeof (char) * (used + 1));
+  used = 0;
+  for (i = 0; i < n; i++)
+    {
+      len = result[i] ? strlen (result[i]) : 0;
+      if (len)
+	memcpy (out + used, result[i], len);
+      out[used + len] = '\0';
+      used += len + 1;
+      if (result[i])
+	free (result[i]);
+    }
+
+  free (result);
+  free (item);
+  *out_len = used;
+  return out;
+}
+
+/*------------------------------------------------------------------*/
+
+PUBLIC void
+lambda_close (interpreter * Interp)
+{
+  parmsLambda *own;
+
+  own = Interp->parms;
+  if (Interp->normal_form)
+    free (Interp->normal_form);
+  if (Interp->program)
+    free (Interp->program);
+  free_interpreter (Interp);
+  free (own);
+}
+
+/*==================================================================*/
+
+/*
+ * symbol table; names are interned with their length, and at most
+ * name_length characters of a name count.  symbol_slot is an open
+ * addressed index on the full-string hash; a slot holds an id only
+ * while that id is in use and still points back at the slot, so
+ * forget_symbols() empties it by lowering fresh.  The table grows
+ * beyond symbol_table_size as needed.
+ */
+
+PRIVATE int
+locate (interpreter * L, const char *name, int length)
+{
+  unsigned int h;
+  int s;
+  int p;
+
+  if (length > L->parms->name_length)
+    length = L->parms->name_length;
+  h = symbol_hash (name, length);
+
+  for (s = h & L->symbol_mask;; s = (s + 1) & L->symbol_mask)
+    {
+      p = L->symbol_slot[s];
+      if (p == 0 || p > L->fresh || L->table[p].slot != s)
+	break;			/* empty */
+      if (L->table[p].hash == h && L->table[p].length == length
+	  && memcmp (L->table[p].symbol, name, length) == 0)
+	return p;
+    }
+
+  /* allocate new name */
+
+  if (L->fresh == L->symbols)
+    grow_symbols (L);
+  p = ++L->fresh;
+  memcpy (L->table[p].symbol, name, length);
+  L->table[p].symbol[length] = '\0';
+  L->table[p].length = length;
+  L->table[p].hash = h;
+  L->table[p].key = 0;
+  L->table[p].slot = s;
+  L->symbol_slot[s] = p;
+
+  if (2 * L->fresh > L->symbol_mask)
+    rehash_symbols (L, 2 * (L->symbol_mask + 1));
+  return p;
+}
+
+/*------------------------------------------------------------------*/
+
+PRIVATE unsigned int
+symbol_hash (const char *name, int length)
+{
+  unsigned int h;
+  int i;
+
+  h = 2166136261u;		/* FNV-1a */
+  for (i = 0; i < length; i++)
+    h = (h ^ (unsigned char) name[i]) * 16777619u;
+  return h;
+}
+
+/*------------------------------------------------------------------*/
+
+/* doubles the table and the lists indexed up to its size */
+
+PRIVATE void
+grow_symbols (interpreter * L)
+{
+  int size;
+  int i;
+
+  size = (L->symbols > 0) ? 2 * L->symbols : 16;
+  L->table = (element *) realloc (L->table, sizeof (element) * (size + 1));
+  L->identifiers = (int *) realloc (L->identifiers, sizeof (int) * (size + 1));
+  L->free_vars = (int *) realloc (L->free_vars, sizeof (int) * (size + 1));
+  L->symbol_mark = (int *) realloc (L->symbol_mark, sizeof (int) * (size + 1));
+  if (L->table == NULL || L->identifiers == NULL || L->free_vars == NULL
+      || L->symbol_mark == NULL)
+    nrerror ("grow_symbols: out of memory");
+  memset (L->symbol_mark + L->symbols + 1, 0, sizeof (int) * (size - L->symbols));
+
+  for (i = L->symbols + 1; i <= size; i++)
+    {
+      memset (&L->table[i], 0, sizeof (element));
+      L->table[i].symbol = (char *) space (sizeof (char) * (L->parms->name_length + 1));
+    }
+  L->symbols = size;
+}
+
+/*------------------------------------------------------------------*/
+
+PRIVATE void
+rehash_symbols (interpreter * L, int slots)
+{
+  int s;
+  int p;
+
+  free (L->symbol_slot);
+  L->symbol_slot = (int *) space (sizeof (int) * slots);
+  L->symbol_mask = slots - 1;
+
+  for (p = 1; p <= L->fresh; p++)
+    {
+      for (s = L->table[p].hash & L->symbol_mask; L->symbol_slot[s] != 0;
+	   s = (s + 1) & L->symbol_mask);
+      L->symbol_slot[s] = p;
+      L->table[p].slot = s;
+    }
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * drops all symbols entered after the built-ins; their slots no longer
+ * count once their ids are above fresh or reused elsewhere.
+ */
+
+PRIVATE void
+forget_symbols (interpreter * L)
+{
+  L->fresh = L->reserved;
+}
+
+/*==================================================================*/
+
+/*
+ * the characters of a token after the first are consumed as one run,
+ * found by scan_run() and read straight out of the input; only the
+ * character after the run goes through str_getc().
+ */
+
+PRIVATE char
+get_token (interpreter * L, int *n, float *x)
+{
+  char c;
+  char *run;
+  size_t i;
+  size_t len;
+
+  *n = 0;
+
+  /* skip consecutive blanks, new line chars, and markers */
+
+  while (L->char_class[(unsigned char) L->peek] == CC_BLANK)
+    L->peek = str_getc (L, L->input_expression);
+
+  if (L->char_class[(unsigned char) L->peek] == CC_LETTER)
+    {				/* identifier token */
+      run = L->input_expression + L->char_count - 1;
+      len = scan_run (L, CC_LETTER | CC_DIGIT) + 1;
+      *n = locate (L, run, len < (size_t) INT_MAX ? (int) len : INT_MAX);
+      L->peek = str_getc (L, L->input_expression);
+      c = 'a';
+    }				/* end of identifier token */
+  else if (L->char_class[(unsigned char) L->peek] == CC_DIGIT)
+    {				/* numeric token */
+      c = 'i';			/* integer */
+      run = L->input_expression + L->char_count - 1;
+      len = scan_run (L, CC_DIGIT) + 1;
+      for (i = 0; i < len; i++)
+	*n = 10 * (*n) + (run[i] - '0');
+      L->peek = str_getc (L, L->input_expression);
+      if (L->peek == '.')
+	{			/* real */
+	  c = 'r';
+	  L->peek = str_getc (L, L->input_expression);
+	  *x = *n;
+	  if (L->char_class[(unsigned char) L->peek] == CC_DIGIT)
+	    {
+	      run = L->input_expression + L->char_count - 1;
+	      len = scan_run (L, CC_DIGIT) + 1;
+	      *x = fraction (*n, run, len);
+	      L->peek = str_getc (L, L->input_expression);
+	    }
+	}
+    }				/* end of numeric token */
+  else
+    {				/* other token */
+      c = L->peek;
+      L->peek = str_getc (L, L->input_expression);
+    }
+
+  if (c == '<')
+    {
+      if (L->peek == '=')
+	{
+	  L->peek = str_getc (L, L->input_expression);
+	  *n = 3;
+	}
+      else if (L->peek == '>')
+	{
+	  L->peek = str_getc (L, L->input_expression);
+	  *n = 5;
+	}
+      else
+	*n = 1;
+    }
+  else if (c == '>')
+    {
+      if (L->peek == '=')
+	{
+	  L->peek = str_getc (L, L->input_expression);
+	  *n = 4;
+	}
+      else
+	*n = 2;
+    }
+  return c;
+}
+
+/*------------------------------------------------------------------*/
+
+/* the value of a real with the given integer part and n decimals */
+
+PRIVATE float
+fraction (int whole, const char *digit, size_t n)
+{
+  float x;
+  float place;
+  size_t i;
+
+  x = whole;
+  place = 1.;
+  for (i = 0; i < n; i++)
+    {
+      place /= 10.;
+      x = x + (digit[i] - '0') * place;
+    }
+  return x;
+}
+
+/*==================================================================*/
+
+PRIVATE int
+r_child (interpreter * L, int point)
+{
+  register int child;
+
+  child = OP2 (point);
+  while (CODE (child) == 0)
+    child = OP2 (child);
+  OP2 (point) = child;
+
+  return child;
+}
+
+/*==================================================================*/
+
+PRIVATE int
+l_child (interpreter * L, int point)
+{
+  register int child;
+
+  child = OP1 (point);
+  while (CODE (child) == 0)
+    child = OP2 (child);
+  OP1 (point) = child;
+
+  return child;
 }
 
 /*==================================================================*/
 
+/* initialization of the heap */
+
 PRIVATE void
-print_expression (int rt)
+clear (interpreter * L)
 {
-  static int track[SIZE + 1];
+  int i;
+
+  CODE (0) = 12;		/* NIL code */
+  L->char_count = 0;		/* reset str_getc() char_count */
+  L->input_length = LAMBDA_NUL;
+  L->input_end = 0;
+  L->terminate = FALSE;
+  L->reductions = 0;		/* reset reduction counter */
+  L->cycles = 0;		/* reset cycle counter */
+  L->standard = FALSE;
+  for (i = 1; i <= L->n_identifiers; i++)
+    L->symbol_mark[L->identifiers[i]] &= ~SYM_LISTED;
+  L->n_identifiers = 0;
+  L->error_number = 0;
+  L->error.cycle_limit = 0;	/* reset step limit flag */
+  L->error.space_limit = 0;	/* reset space limit flag */
+  L->error.output_overflow = 0;	/* print expression overflow flag */
+  L->error.symbol_table_overflow = 0;	/* symbol table overflow flag */
+  L->error.not_free_overflow = 0;	/* not_free() overflow flag */
+  L->error.no_nf_term = 0;
+
+  L->output_length = 0;
+
+  /* 
+   * nodes are initialized when get_node() hands them out, so emptying
+   * the heap only means moving the high-water mark back to the top.
+   */
+
+  L->bump = L->heap_size + 1;
+  L->bump_floor = 1;
+  L->sweep = 0;
+  L->fresh_marks = FALSE;
+  L->garbage_collected = 0;
+}
+
+/*==================================================================*/
+
+PRIVATE void
+allocate_heap (interpreter * L)
+{
+  int n;
+
+  n = L->heap_size + 1;
+#ifdef SOA_HEAP
+  L->heap_code = (int *) space (sizeof (int) * n);
+  L->heap_op1 = (int *) space (sizeof (int) * n);
+  L->heap_u = (heap_value *) space (sizeof (heap_value) * n);
+  L->heap_scope = NULL;	/* see need_scope() */
+#else
+  L->heap = (heap_node *) space (sizeof (heap_node) * n);
+#endif
+  L->mark = (unsigned int *) space (sizeof (unsigned int) * n);
+  L->epoch = 0;
+  L->gc_mark = (unsigned int *) space (sizeof (unsigned int) * n);
+  L->gc_epoch = 0;
+  L->fv = NULL;
+  if (L->parms->free_var_cache)
+    L->fv = (fv_set *) space (sizeof (fv_set) * n);
+}
+
+/*------------------------------------------------------------------*/
+
+PRIVATE void
+release_heap (interpreter * L)
+{
+#ifdef SOA_HEAP
+  free (L->heap_code);
+  free (L->heap_op1);
+  free (L->heap_u);
+  if (L->heap_scope)
+    free (L->heap_scope);
+#else
+  free (L->heap);
+#endif
+  free (L->mark);
+  free (L->gc_mark);
+  if (L->fv)
+    free (L->fv);
+}
+
+/*------------------------------------------------------------------*/
+
+/* scope ids are needed only by standardize(); allocate them on first use */
+
+PRIVATE void
+need_scope (interpreter * L)
+{
+#ifdef SOA_HEAP
+  if (L->heap_scope == NULL)
+    L->heap_scope = (int *) space (sizeof (int) * (L->heap_size + 1));
+#else
+  (void) L;			/* scope lives in the heap nodes */
+#endif
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * starts a new graph walk: a node is visited iff its mark equals the
+ * current epoch, so no pass is needed to unmark nodes afterwards.
+ */
+
+PRIVATE void
+new_epoch (interpreter * L)
+{
+  if (++L->epoch == 0)
+    {				/* wrapped around: forget all old marks */
+      memset (L->mark, 0, sizeof (unsigned int) * (L->heap_size + 1));
+      L->epoch = 1;
+    }
+}
+
+/*------------------------------------------------------------------*/
+
+/* a node fresh from get_node(): an indirection with op1 = 0 */
+
+PRIVATE void
+init_node (interpreter * L, int n)
+{
+  CODE (n) = 0;
+  OP1 (n) = 0;
+  OP2 (n) = 0;
+#ifdef SOA_HEAP
+  if (L->heap_scope)
+#endif
+    SCOPE (n) = 0;
+  if (L->fv)
+    L->fv[n].n = FV_UNKNOWN;
+}
+
+/*==================================================================*/
+
+PRIVATE void
+garbage (interpreter * L)
+{
+  int *track;
+  int code;
+  int point;
+  int top;
+  boolean more;
+
+  L->garbage_collected = 1;
+
+  if (++L->gc_epoch == 0)
+    {				/* wrapped around: forget all old marks */
+      memset (L->gc_mark, 0, sizeof (unsigned int) * (L->heap_size + 1));
+      L->gc_epoch = 1;
+    }
+
+  more = TRUE;
+  top = 0;
+  point = L->root;
+  track = L->track.item;
+
+  while (more)
+    {				/* marking phase */
+      code = CODE (point);
+      if (code > 3)
+	MARK (point);
+      if (MARKED (point))
+	{			/* may be NIL */
+	  if (top > 0)
+	    point = track[top--];
+	  else
+	    more = FALSE;
+	}
+      else
+	{
+	  MARK (point);
+	  if ((code == 2) || (code == 3))
+	    {
+	      track = stack_room (&L->track, top);
+	      track[++top] = r_child (L, point);
+	      point = l_child (L, point);
+	    }
+	  else
+	    point = r_child (L, point);	/* code must be less than 2 */
+	}
+    }				/* end of marking phase */
+
+  L->sweep = L->heap_size;	/* get_node() sweeps lazily */
+  L->fresh_marks = TRUE;
+  L->collections++;
+}
+
+/*------------------------------------------------------------------*/
+
+PRIVATE void *
+resize (void *block, size_t size)
+{
+  block = realloc (block, size);
+  if (block == NULL)
+    nrerror ("grow_heap: allocation failure");
+  return block;
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * doubles the heap, up to parms->max_heap_size; nodes keep their
+ * indices and the new ones become the unused range above the old top.
+ * Only called from get_node() when every node is live, so the new
+ * nodes need no marks.
+ */
+
+PRIVATE void
+grow_heap (interpreter * L)
+{
+  int old;
+  int n;
+
+  old = L->heap_size;
+  L->heap_size = 2 * old;
+  if (L->heap_size > L->parms->max_heap_size)
+    L->heap_size = L->parms->max_heap_size;
+  n = L->heap_size + 1;
+
+#ifdef SOA_HEAP
+  L->heap_code = (int *) resize (L->heap_code, sizeof (int) * n);
+  L->heap_op1 = (int *) resize (L->heap_op1, sizeof (int) * n);
+  L->heap_u = (heap_value *) resize (L->heap_u, sizeof (heap_value) * n);
+  if (L->heap_scope)
+    L->heap_scope = (int *) resize (L->heap_scope, sizeof (int) * n);
+#else
+  L->heap = (heap_node *) resize (L->heap, sizeof (heap_node) * n);
+#endif
+  L->mark = (unsigned int *) resize (L->mark, sizeof (unsigned int) * n);
+  memset (L->mark + old + 1, 0, sizeof (unsigned int) * (n - old - 1));
+  L->gc_mark = (unsigned int *) resize (L->gc_mark, sizeof (unsigned int) * n);
+  memset (L->gc_mark + old + 1, 0, sizeof (unsigned int) * (n - old - 1));
+  if (L->fv)
+    L->fv = (fv_set *) resize (L->fv, sizeof (fv_set) * n);
+
+  L->bump = L->heap_size + 1;
+  L->bump_floor = old + 1;
+  L->fresh_marks = FALSE;
+  L->heap_growths++;
+}
+
+/*==================================================================*/
+
+PRIVATE int
+get_node (interpreter * L)
+{
+  int gn;
+
+  for (;;)
+    {
+      if (L->bump > L->bump_floor)
+	{			/* never used since clear() */
+	  gn = --L->bump;
+	  break;
+	}
+
+      while (L->sweep > 0 && MARKED (L->sweep))
+	L->sweep--;		/* incremental sweep */
+      if (L->sweep > 0)
+	{
+	  gn = L->sweep--;
+	  L->fresh_marks = FALSE;
+	  break;
+	}
+
+      if (!L->reducing)
+	L->fresh_marks = TRUE;	/* a graph being built is all live */
+      if (L->fresh_marks && L->heap_size < L->parms->max_heap_size)
+	{			/* a full sweep after marking found nothing */
+	  grow_heap (L);
+	  continue;
+	}
+      if (L->fresh_marks)
+	{
+	  L->iterate = FALSE;
+	  if (!L->error.space_limit)
+	    L->error.space_limit_hits += 1;
+	  L->error.space_limit = TRUE;
+	  err (L, "ran out of space.\n");
+	  return FALSE;
+	}
+
+      garbage (L);
+    }
+
+  init_node (L, gn);
+  return gn;
+}
+
+/*==================================================================*/
+
+/*
+ * prints the graph at rt without writing to it.  The rest of a list
+ * waits on the track stack complemented (~node), so that it prints as
+ * the continuation of its list: a ',' instead of '[', and no ')'.
+ */
+
+PRIVATE void
+print_expression (interpreter * L, int rt)
+{
+  int *track;
   int point;
   int top;
   int count;
   int next;
-  int i;
-  char num[20];
+  int n;
+  char num[64];
   boolean more;
+  boolean tail;			/* point continues a list */
 
   count = 0;
   point = rt;
   top = 0;
   more = TRUE;
+  tail = FALSE;
+  track = L->track.item;
 
-  if (L->standard)
+  if (L->standard == TRUE)
     L->scope_offset = 0;
+  if (L->standard == FUSED)
+    for (n = 1; n <= L->scope_offset; n++)
+      {				/* binders of the free variables */
+	if ((size_t) count + SLACK >= L->output_size)
+	  grow_output (L, count + SLACK);
+	print_char (L, '\\', &count);
+	print_char (L, L->parms->standard_variable, &count);
+	print_int (L, n, &count);
+	print_char (L, '.', &count);
+      }
 
   while (more)
     {
-      switch (L->heap[point].code)
+      if ((size_t) count + SLACK >= L->output_size)
+	grow_output (L, count + SLACK);
+
+      switch (CODE (point))
 	{
 
 	case 0:		/* ---- indirection ---- */
 
-	  point = L->heap[point].u.op2;
+	  point = OP2 (point);
 	  break;
 
 	case 1:		/* ---- abstraction ---- */
 
 	  /* if (count > (78 - L->parms->name_length)) count = 80; */
-	  print_char ('\\', &count);
-	  next = L->heap[point].op1;
-	  print_id (next, point, &count);
-	  print_char ('.', &count);
-	  point = L->heap[point].u.op2;
+	  print_char (L, '\\', &count);
+	  next = OP1 (point);
+	  if (L->standard == FUSED)
+	    print_binder (L, next, top, &count);
+	  else
+	    print_id (L, next, point, &count);
+	  print_char (L, '.', &count);
+	  point = OP2 (point);
+	  tail = FALSE;
 	  break;
 
 	case 2:		/* ---- application ---- */
 
-	  if (top < SIZE)
-	    track[++top] = L->heap[point].u.op2;
-	  else
-	    {
-	      more = FALSE;
-	      err ("print_expression track overflow.\n");
-	    }
-	  print_char ('(', &count);
-	  point = L->heap[point].op1;
+	  track = stack_room (&L->track, top);
+	  track[++top] = OP2 (point);
+	  print_char (L, '(', &count);
+	  point = OP1 (point);
+	  tail = FALSE;
 	  break;
 
-	case 3:
-	case 13:		/* ---- list structure ---- */
-
-	  if (L->heap[point].code == 3)
-	    print_char ('[', &count);
-	  else
-	    {
-	      print_char (',', &count);
-	      L->heap[point].code = 3;
-	    }
-
-	  if (top < SIZE)
-	    {
-	      top++;
-	      next = r_child (point);	/* needed here */
-	      track[top] = next;
-	      if ((L->heap[next].code == 3) || (L->heap[next].code == 4))
-		L->heap[next].code = L->heap[next].code + 10;
-	    }
-	  else
-	    {
-	      more = FALSE;
-	      err ("print_expression track overflow.\n");
-	    }
-	  point = L->heap[point].op1;
-	  break;
+	case 3:		/* ---- list structure ---- */
 
-	case 4:
-	case 14:		/* ---- empty list or end of list ---- */
+	  print_char (L, tail ? ',' : '[', &count);
+	  for (next = OP2 (point); CODE (next) == 0; next = OP2 (next));
+	  track = stack_room (&L->track, top);
+	  track[++top] = (CODE (next) == 3 || CODE (next) == 4) ? ~next : next;
+	  point = OP1 (point);
+	  tail = FALSE;
+	  break;
 
-	  if (L->heap[point].code == 4)
-	    print_char ('[', &count);
-	  else
-	    L->heap[point].code = 4;
+	case 4:		/* ---- empty list or end of list ---- */
 
-	  print_char (']', &count);
-	  point = pop (track, &top, &more, &count);
+	  if (!tail)
+	    print_char (L, '[', &count);
+	  print_char (L, ']', &count);
+	  point = pop (L, track, &top, &more, &tail, &count);
 	  break;
 
 	case 5:		/* ---- Y combinator ---- */
 
-	  print_char ('?', &count);
-	  point = pop (track, &top, &more, &count);
+	  print_char (L, '?', &count);
+	  point = pop (L, track, &top, &more, &tail, &count);
 	  break;
 
 	case 6:		/* ---- head of list ---- */
 
-	  print_char (HEAD, &count);
-	  point = pop (track, &top, &more, &count);
+	  print_char (L, HEAD, &count);
+	  point = pop (L, track, &top, &more, &tail, &count);
 	  break;
 
 	case 7:		/* ---- tail of list ---- */
 
-	  print_char (TAIL, &count);
-	  point = pop (track, &top, &more, &count);
+	  print_char (L, TAIL, &count);
+	  point = pop (L, track, &top, &more, &tail, &count);
 	  break;
 
 	case 8:		/* ---- cons operator ---- */
 
-	  print_char ('&', &count);
-	  point = pop (track, &top, &more, &count);
+	  print_char (L, '&', &count);
+	  point = pop (L, track, &top, &more, &tail, &count);
 	  break;
 
 	case 9:		/* ---- integer ---- */
 
-	  sprintf (num, "%d", L->heap[point].u.op2);
-	  for (i = 0; num[i] != '\0'; i++)
-	    print_char (num[i], &count);
-	  point = pop (track, &top, &more, &count);
+	  print_int (L, OP2 (point), &count);
+	  point = pop (L, track, &top, &more, &tail, &count);
 	  break;
 
 	case 10:		/* ---- real ---- */
 
-	  sprintf (num, "%5.5f", L->heap[point].u.alt);
-	  for (i = 0; num[i] != '\0'; i++)
-	    print_char (num[i], &count);
-	  point = pop (track, &top, &more, &count);
+	  n = snprintf (num, sizeof (num), "%5.5f", ALT (point));
+	  print_text (L, num, n, &count);
+	  point = pop (L, track, &top, &more, &tail, &count);
 	  break;
 
 	case 11:		/* ---- variable or key word ---- */
 
-	  next = L->heap[point].op1;
-	  print_id (next, point, &count);
-	  point = pop (track, &top, &more, &count);
+	  next = OP1 (point);
+	  if (L->standard == FUSED)
+	    print_bound (L, next, &count);
+	  else
+	    print_id (L, next, point, &count);
+	  point = pop (L, track, &top, &more, &tail, &count);
 	  break;
 
 	case 15:		/* ---- arithmetic operator ---- */
 
-	  switch (L->heap[point].u.op2)
+	  switch (OP2 (point))
 	    {
 
 	    case 1:
-	      print_char ('+', &count);
+	      print_char (L, '+', &count);
 	      break;
 	    case 2:
-	      print_char ('-', &count);
+	      print_char (L, '-', &count);
 	      break;
 	    case 3:
-	      print_char ('*', &count);
+	      print_char (L, '*', &count);
 	      break;
 	    case 4:
-	      print_char ('/', &count);
+	      print_char (L, '/', &count);
 	      break;
 
 	    }
-	  point = pop (track, &top, &more, &count);
+	  point = pop (L, track, &top, &more, &tail, &count);
 	  break;
 
 	case 16:		/* ---- relational operator ---- */
 
-	  switch (L->heap[point].u.op2)
+	  switch (OP2 (point))
 	    {
 
 	    case 0:
-	      print_char ('=', &count);
+	      print_char (L, '=', &count);
 	      break;
 	    case 1:
-	      print_char ('<', &count);
+	      print_char (L, '<', &count);
 	      break;
 	    case 2:
-	      print_char ('>', &count);
+	      print_char (L, '>', &count);
 	      break;
 	    case 3:
-	      print_char ('<', &count);
-	      print_char ('=', &count);
+	      print_char (L, '<', &count);
+	      print_char (L, '=', &count);
 	      break;
 	    case 4:
-	      print_char ('>', &count);
-	      print_char ('=', &count);
+	      print_char (L, '>', &count);
+	      print_char (L, '=', &count);
 	      break;
 
 	    case 5:
-	      print_char ('<', &count);
-	      print_char ('>', &count);
+	      print_char (L, '<', &count);
+	      print_char (L, '>', &count);
 	      break;
 	    }
-	  point = pop (track, &top, &more, &count);
+	  point = pop (L, track, &top, &more, &tail, &count);
 	  break;
 
 	default:		/* ---- renaming prefix ---- */
 
-	  if (L->heap[point].code < 0)
+	  if (CODE (point) < 0)
 	    {
-	      print_char ('{', &count);
-	      print_id (L->heap[point].code, point, &count);
-	      print_char ('/', &count);
-	      print_id (L->heap[point].op1, point, &count);
-	      print_char ('}', &count);
-	      point = r_child (point);
+	      print_char (L, '{', &count);
+	      print_id (L, CODE (point), point, &count);
+	      print_char (L, '/', &count);
+	      print_id (L, OP1 (point), point, &count);
+	      print_char (L, '}', &count);
+	      for (point = OP2 (point); CODE (point) == 0; point = OP2 (point));
+	      tail = FALSE;
 	    }
 	  else
 	    {
-	      err ("\n");
-	      err ("Wrong Expression!\n");
+	      err (L, "\n");
+	      err (L, "Wrong Expression!\n");
 	      more = FALSE;
 	    }
 	  break;
@@ -863,102 +2265,267 @@ print_expression (int rt)
     }				/* while */
 
   L->output_expression[count] = '\0';
+  L->output_length = count;
 }
 
 /*------------------------------------------------------------------*/
 
-PRIVATE boolean
-print_char (int x, int *count)
+/*
+ * the output buffer grows as needed; print_expression() keeps SLACK
+ * characters of room at the start of each step, and print_text()
+ * after each token, which is enough for the single characters a step
+ * adds, so print_char() does not check.
+ */
+
+PRIVATE void
+print_char (interpreter * L, int x, int *count)
+{
+  L->output_expression[(*count)++] = x;
+}
+
+/*------------------------------------------------------------------*/
+
+PRIVATE void
+print_text (interpreter * L, const char *text, int n, int *count)
+{
+  if ((size_t) *count + n + SLACK >= L->output_size)
+    grow_output (L, (size_t) *count + n + SLACK);
+  memcpy (L->output_expression + *count, text, n);
+  *count += n;
+}
+
+/*------------------------------------------------------------------*/
+
+PRIVATE void
+print_int (interpreter * L, int value, int *count)
+{
+  char digits[12];
+  char *d;
+  unsigned int u;
+
+  d = digits + sizeof (digits);
+  u = (value < 0) ? -(unsigned int) value : (unsigned int) value;
+  do
+    {
+      *--d = '0' + u % 10;
+      u /= 10;
+    }
+  while (u);
+  if (value < 0)
+    *--d = '-';
+  print_text (L, d, digits + sizeof (digits) - d, count);
+}
+
+/*------------------------------------------------------------------*/
+
+/* makes room for need characters, SLACK more than parms->max_output at most */
+
+PRIVATE void
+grow_output (interpreter * L, size_t need)
 {
-  if (*count > L->parms->heap_size)
+  size_t size;
+
+  if (L->parms->max_output > 0 && need > (size_t) L->parms->max_output + SLACK)
     {
       L->error.output_overflow = TRUE;
-      err ("print overflow.\n");
-      return FALSE;
+      L->error.output_overflow_hits++;
+      err (L, "print overflow.\n");
     }
-  L->output_expression[*count] = x;
-  (*count)++;
-  return TRUE;
+  for (size = L->output_size; size <= need; size *= 2);
+  L->output_expression = (char *) resize (L->output_expression, sizeof (char) * size);
+  L->output_size = size;
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-print_id (int dummy, int point, int *count)
+print_id (interpreter * L, int dummy, int point, int *count)
 {
-  char name[SMALL], num[20];
-  int index;
-  
   if (dummy > 0)
     {
 
-      if (L->standard && L->heap[point].scope != 0)
+      if (L->standard && SCOPE (point) != 0)
 	{
-	  make_name (L->heap[point].scope);
-	  for (index = 0; index < strlen (L->new_name); index++)
-	    print_char (L->new_name[index], count);
+	  print_char (L, L->parms->standard_variable, count);
+	  print_int (L, make_name (L, SCOPE (point)), count);
 	}
       else
-	{
-	  strcpy (name, L->table[dummy].symbol);
-	  for (index = 1; index <= L->parms->name_length; index++)
-	    {
-	      if (name[index] != ' ')
-		print_char (name[index], count);
-	    }
-	}
+	print_text (L, L->table[dummy].symbol, L->table[dummy].length, count);
     }
   else
     {
-      print_char ('$', count);
-      sprintf (num, "%d", -dummy);
-      for (index = 0; num[index] != '\0'; index++)
-	print_char (num[index], count);
+      print_char (L, '$', count);
+      print_int (L, -dummy, count);
     }
 }
 
 /*------------------------------------------------------------------*/
 
+/*
+ * names for standard_form(): the abstractions in scope sit on the
+ * trace stack as (id, number, track height) triples; pop() drops them
+ * when the track stack falls below the height their body began at.
+ * The k-th abstraction printed is named k + scope_offset, the i-th
+ * free variable scope_offset - i + 1.
+ */
+
+PRIVATE void
+print_binder (interpreter * L, int id, int top, int *count)
+{
+  int *binder;
+
+  binder = stack_room (&L->trace, 3 * L->binders + 2);
+  L->binders++;
+  binder[3 * L->binders - 2] = id;
+  binder[3 * L->binders - 1] = ++L->binder_count + L->scope_offset;
+  binder[3 * L->binders] = top;
+  print_char (L, L->parms->standard_variable, count);
+  print_int (L, binder[3 * L->binders - 1], count);
+}
+
+/*------------------------------------------------------------------*/
+
 PRIVATE void
-make_name (int scpe)
+print_bound (interpreter * L, int id, int *count)
 {
+  int *binder;
   int i;
-  int redo;
-  char numb[10];
 
-  do
+  binder = L->trace.item;
+  for (i = L->binders; i > 0; i--)
+    if (binder[3 * i - 2] == id)
+      break;
+  if (i > 0)
+    i = binder[3 * i - 1];
+  else if (id > 0 && L->table[id].key != 0)
+    {				/* key word */
+      print_text (L, L->table[id].symbol, L->table[id].length, count);
+      return;
+    }
+  else
+    {
+      for (i = 1; L->names.item[i] != id; i++);
+      i = L->scope_offset - i + 1;
+    }
+  print_char (L, L->parms->standard_variable, count);
+  print_int (L, i, count);
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * the number of the bound variable scpe; numbers that would print as
+ * a free variable are stepped around for the rest of the term.
+ */
+
+PRIVATE int
+make_name (interpreter * L, int scpe)
+{
+  while (L->n_suffixes > 0 && taken (L, scpe + L->scope_offset))
+    L->scope_offset++;
+  return scpe + L->scope_offset;
+}
+
+/*------------------------------------------------------------------*/
+
+/* enters n for every free variable named standard_variable n */
+
+PRIVATE void
+taken_suffixes (interpreter * L)
+{
+  suffix_entry *entry;
+  unsigned int mask;
+  unsigned int i;
+  char *s;
+  int value;
+  int size;
+  int k;
+
+  L->n_suffixes = 0;
+  size = 16;
+  while (size < 2 * L->n_free_vars)
+    size *= 2;
+  if (L->suffix_size < size)
+    {
+      if (L->suffix)
+	free (L->suffix);
+      L->suffix = (suffix_entry *) space (sizeof (suffix_entry) * size);
+      L->suffix_size = size;
+      L->suffix_generation = 0;
+    }
+  if (++L->suffix_generation == 0)
+    {				/* wrapped around: forget all old entries */
+      memset (L->suffix, 0, sizeof (suffix_entry) * L->suffix_size);
+      L->suffix_generation = 1;
+    }
+
+  mask = L->suffix_size - 1;
+  for (k = 1; k <= L->n_free_vars; k++)
     {
-      int_to_char (scpe + L->scope_offset, numb);
-      L->new_name[0] = L->parms->standard_variable;
-      L->new_name[1] = '\0';
-      strcat (L->new_name, numb);
-      /* check if new composite name is free */
-      redo = 0;
-      for (i = 1; i <= L->n_free_vars; i++)
+      s = L->table[L->free_vars[k]].symbol;
+      if (s[0] != L->parms->standard_variable || s[1] < '1' || s[1] > '9')
+	continue;
+      for (value = 0, s++; *s >= '0' && *s <= '9'; s++)
+	{
+	  if (value > (INT_MAX - (*s - '0')) / 10)
+	    break;
+	  value = 10 * value + (*s - '0');
+	}
+      if (*s)
+	continue;		/* not a number make_name() can reach */
+      for (i = (unsigned int) mix (0, (uint32_t) value) & mask;; i = (i + 1) & mask)
 	{
-	  if (strcmp (L->new_name, L->free_vars[i]) == 0)
+	  entry = L->suffix + i;
+	  if (entry->generation != L->suffix_generation)
 	    {
-	      redo = 1;
-	      L->scope_offset++;
+	      entry->generation = L->suffix_generation;
+	      entry->value = value;
+	      L->n_suffixes++;
 	      break;
 	    }
+	  if (entry->value == value)
+	    break;
 	}
     }
-  while (redo);
+}
+
+/*------------------------------------------------------------------*/
+
+PRIVATE boolean
+taken (interpreter * L, int value)
+{
+  suffix_entry *entry;
+  unsigned int mask;
+  unsigned int i;
+
+  mask = L->suffix_size - 1;
+  for (i = (unsigned int) mix (0, (uint32_t) value) & mask;; i = (i + 1) & mask)
+    {
+      entry = L->suffix + i;
+      if (entry->generation != L->suffix_generation)
+	return FALSE;
+      if (entry->value == value)
+	return TRUE;
+    }
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE int
-pop (int *track, int *top, boolean * more, int *count)
+pop (interpreter * L, int *track, int *top, boolean * more, boolean * tail, int *count)
 {
   int i;
 
   if (*top > 0)
     {
       i = track[(*top)--];
-      if ((L->heap[i].code != 13) && (L->heap[i].code != 14))
-	print_char (')', count);
+      if (L->standard == FUSED)
+	while (L->binders > 0 && L->trace.item[3 * L->binders] > *top)
+	  L->binders--;		/* out of the body */
+      *tail = (i < 0);
+      if (*tail)
+	return ~i;
+      print_char (L, ')', count);
       return i;
     }
   else
@@ -970,12 +2537,342 @@ pop (int *track, int *top, boolean * more, int *count)
 
 /*==================================================================*/
 
+/*
+ * alpha-invariant hash of the term at root, in one read-only walk of
+ * the tree print_expression() would print.  Variables count as de
+ * Bruijn indices, free ones as if bound around the term in order of
+ * first occurrence, like bind_all_free_vars() does; key words count by
+ * their id, so alpha-equivalent terms hash alike.  The abstractions at
+ * the root and the implicit ones only count in number, at the end.
+ * Returns 0 if the tree has more than heap_size nodes.
+ */
+
+PRIVATE uint64_t
+canonical_hash (interpreter * L, int root, uint64_t seed)
+{
+  int *track;			/* pending right operands; ~depth restores */
+  int *binder;			/* ids of the enclosing abstractions */
+  int point;
+  int top;
+  int depth;
+  int leading;			/* abstractions at the root */
+  int n_free;
+  int nodes;
+  int code;
+  uint64_t h;
+  union
+    {
+      double real;
+      uint64_t bits;
+    }
+  value;
+
+  track = L->track.item;
+  binder = L->trace.item;
+  h = seed ^ 0x6a09e667f3bcc908ULL;
+  point = root;
+  top = 0;
+  depth = 0;
+  leading = -1;
+  n_free = 0;
+  nodes = 0;
+
+  for (;;)
+    {
+      while (CODE (point) == 0)
+	point = OP2 (point);
+      if (++nodes > L->heap_size)
+	return 0;
+
+      code = CODE (point);
+      if (code != 1 && leading < 0)
+	leading = depth;
+      if (leading >= 0)
+	h = mix (h, (uint64_t) (uint32_t) code);
+
+      if (code == 1)
+	{			/* ---- abstraction ---- */
+	  track = stack_room (&L->track, top);
+	  track[++top] = ~depth;
+	  binder = stack_room (&L->trace, depth);
+	  binder[++depth] = OP1 (point);
+	  point = OP2 (point);
+	  continue;
+	}
+      if (code == 2 || code == 3)
+	{			/* ---- application or list ---- */
+	  track = stack_room (&L->track, top);
+	  track[++top] = OP2 (point);
+	  point = OP1 (point);
+	  continue;
+	}
+      if (code < 0)
+	{			/* ---- renaming prefix ---- */
+	  h = mix (h, hash_variable (L, code, depth, &n_free));
+	  h = mix (h, hash_variable (L, OP1 (point), depth, &n_free));
+	  point = OP2 (point);
+	  continue;
+	}
+
+      switch (code)
+	{
+	case 9:		/* ---- integer ---- */
+	case 15:		/* ---- arithmetic operator ---- */
+	case 16:		/* ---- relational operator ---- */
+	  h = mix (h, (uint64_t) (uint32_t) OP2 (point));
+	  break;
+	case 10:		/* ---- real ---- */
+	  value.real = ALT (point);
+	  h = mix (h, value.bits);
+	  break;
+	case 11:		/* ---- variable or key word ---- */
+	  h = mix (h, hash_variable (L, OP1 (point), depth, &n_free));
+	  break;
+	}
+
+      for (;;)
+	{			/* next pending operand */
+	  if (top == 0)
+	    {
+	      h = mix (h, (uint64_t) (leading + n_free));
+	      h ^= h >> 31;
+	      h *= 0xbf58476d1ce4e5b9ULL;
+	      return h ^ (h >> 29);
+	    }
+	  point = track[top--];
+	  if (point >= 0)
+	    break;
+	  depth = ~point;
+	}
+    }
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * the token of a variable occurrence at depth; the i-th free variable
+ * is bound just outside the term, the first one innermost.
+ */
+
+PRIVATE uint64_t
+hash_variable (interpreter * L, int id, int depth, int *n_free)
+{
+  int *names;
+  int i;
+
+  for (i = depth; i > 0; i--)
+    if (L->trace.item[i] == id)
+      return ((uint64_t) 1 << 32) | (uint64_t) (depth - i);
+
+  if (id > 0 && L->table[id].key != 0)
+    return ((uint64_t) 2 << 32) | (uint64_t) id;	/* key word */
+
+  names = L->names.item;
+  for (i = 1; i <= *n_free; i++)
+    if (names[i] == id)
+      break;
+  if (i > *n_free)
+    {
+      names = stack_room (&L->names, *n_free);
+      names[++(*n_free)] = id;
+    }
+  return ((uint64_t) 1 << 32) | (uint64_t) (depth + i - 1);
+}
+
+/*------------------------------------------------------------------*/
+
+PRIVATE uint64_t
+mix (uint64_t h, uint64_t token)
+{
+  h = (h ^ token) * 0x9e3779b97f4a7c15ULL;
+  return h ^ (h >> 32);
+}
+
+/*==================================================================*/
+
+/*
+ * hash-consing: after parse(), structurally identical closed subterms
+ * below root are made to share one heap node.  A closed subterm is
+ * only ever rewritten in place into something equivalent, so all its
+ * users may see the rewrite.  Only pure terms (abstractions,
+ * applications, variables, numbers) are shared; lists and built-ins
+ * stay as parsed.  Indirections (recursive lets) are not followed.
+ */
+
+PRIVATE void
+hash_cons (interpreter * L, int root)
+{
+  int *track;			/* nodes to enter; ~node to leave */
+  int *binder;			/* ids of the enclosing abstractions */
+  int *value;			/* representative, reach of finished subterms */
+  int top;
+  int depth;
+  int n_values;
+  int point;
+  int code;
+  int child;
+  int left;
+  int right;
+  int rep;
+  int reach;			/* outermost binder referred to; 0: free or impure */
+  int size;
+  int i;
+
+  size = 1;
+  while (size < 2 * (L->heap_size + 1))
+    size *= 2;
+  if (L->cons_size < size)
+    {
+      if (L->cons)
+	free (L->cons);
+      L->cons = (cons_entry *) space (sizeof (cons_entry) * size);
+      L->cons_size = size;
+      L->cons_generation = 0;
+    }
+  if (++L->cons_generation == 0)
+    {				/* wrapped around: forget all old entries */
+      memset (L->cons, 0, sizeof (cons_entry) * L->cons_size);
+      L->cons_generation = 1;
+    }
+
+  track = L->track.item;
+  binder = L->trace.item;
+  value = L->names.item;
+  top = 0;
+  depth = 0;
+  n_values = 0;
+  track[++top] = root;
+
+  while (top > 0)
+    {
+      point = track[top--];
+      if (point >= 0)
+	{
+	  code = CODE (point);
+	  if (code == 1)
+	    {			/* ---- abstraction: enter the body ---- */
+	      track = stack_room (&L->track, top + 1);
+	      track[++top] = ~point;
+	      track[++top] = OP2 (point);
+	      binder = stack_room (&L->trace, depth);
+	      binder[++depth] = OP1 (point);
+	      continue;
+	    }
+	  if (code == 2 || code == 3)
+	    {			/* ---- application or list ---- */
+	      track = stack_room (&L->track, top + 2);
+	      track[++top] = ~point;
+	      track[++top] = OP2 (point);
+	      track[++top] = OP1 (point);
+	      continue;
+	    }
+
+	  reach = 0;
+	  if (code <= 0)
+	    rep = point;	/* ---- indirection: opaque ---- */
+	  else if (code == 11)
+	    {			/* ---- variable or key word ---- */
+	      for (i = depth; i > 0 && binder[i] != OP1 (point); i--);
+	      reach = i;
+	      rep = cons_node (L, point, code, OP1 (point), OP2 (point));
+	    }
+	  else if (code == 9 || code == 10)
+	    {			/* ---- number ---- */
+	      reach = INT_MAX;
+	      rep = cons_node (L, point, code, 0, OP2 (point));	/* the bits of a real */
+	    }
+	  else if (code == 15 || code == 16)
+	    rep = cons_node (L, point, code, 0, OP2 (point));
+	  else
+	    rep = cons_node (L, point, code, 0, 0);
+	}
+      else
+	{
+	  point = ~point;
+	  code = CODE (point);
+	  if (code == 1)
+	    {
+	      depth--;
+	      child = value[n_values - 1];
+	      reach = value[n_values];
+	      n_values -= 2;
+	      if (reach > depth + 1 && child != OP2 (point))
+		{
+		  OP2 (point) = child;
+		  L->shared++;
+		}
+	      rep = cons_node (L, point, code, OP1 (point), child);
+	    }
+	  else
+	    {
+	      left = value[n_values - 3];
+	      right = value[n_values - 1];
+	      if (value[n_values - 2] > depth && left != OP1 (point))
+		{
+		  OP1 (point) = left;
+		  L->shared++;
+		}
+	      if (value[n_values] > depth && right != OP2 (point))
+		{
+		  OP2 (point) = right;
+		  L->shared++;
+		}
+	      reach = (value[n_values - 2] < value[n_values]) ? value[n_values - 2] : value[n_values];
+	      if (code == 3)
+		reach = 0;
+	      n_values -= 4;
+	      rep = cons_node (L, point, code, left, right);
+	    }
+	}
+
+      value = stack_room (&L->names, n_values + 1);
+      value[++n_values] = rep;
+      value[++n_values] = reach;
+    }
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * the first node seen by this hash_cons() pass with key (code, op1, op2),
+ * where operands are representatives; node itself if it is the first.
+ */
+
+PRIVATE int
+cons_node (interpreter * L, int node, int code, int op1, int op2)
+{
+  cons_entry *entry;
+  unsigned int mask;
+  unsigned int i;
+
+  mask = L->cons_size - 1;
+  i = (unsigned int) mix (mix (mix (0, (uint32_t) code), (uint32_t) op1), (uint32_t) op2) & mask;
+  for (;; i = (i + 1) & mask)
+    {
+      entry = L->cons + i;
+      if (entry->generation != L->cons_generation)
+	{
+	  entry->generation = L->cons_generation;
+	  entry->code = code;
+	  entry->op1 = op1;
+	  entry->op2 = op2;
+	  entry->node = node;
+	  return node;
+	}
+      if (entry->code == code && entry->op1 == op1 && entry->op2 == op2)
+	return entry->node;
+    }
+}
+
+/*==================================================================*/
+
 PRIVATE void
-parse (int *rt)
+parse (interpreter * L, int *rt)
 {
   char ch;
   int whole;
   int k;
+  int child;			/* get_node() may move the heap */
   int i;			/* top of the parser stack */
   float decimal;
   boolean ok;
@@ -984,7 +2881,7 @@ parse (int *rt)
   ok = TRUE;
   L->stack[i].a = 'E';
   L->stack[i].b = *rt;
-  ch = get_token (&whole, &decimal);
+  ch = get_token (L, &whole, &decimal);
 
   while ((ch != ' ') && (ch != ';') && ok)
     {
@@ -999,7 +2896,7 @@ parse (int *rt)
 	  else
 	    {
 	      ok = FALSE;
-	      err ("Error )\n");
+	      err (L, "Error )\n");
 	    }
 	  break;
 
@@ -1007,23 +2904,25 @@ parse (int *rt)
 
 	  if (ch == ']')
 	    {
-	      L->heap[L->stack[i].b].code = 4;
+	      CODE (L->stack[i].b) = 4;
 	      i--;
 	    }
 	  else if (ch == ',')
 	    {
 	      k = L->stack[i].b;
-	      L->heap[k].op1 = get_node ();
-	      L->heap[k].u.op2 = get_node ();
-	      L->heap[k].code = 3;
-	      L->stack[i].b = L->heap[k].u.op2;
-	      push ('E', &i, &ok);
-	      L->stack[i].b = L->heap[k].op1;
+	      child = get_node (L);
+	      OP1 (k) = child;
+	      child = get_node (L);
+	      OP2 (k) = child;
+	      CODE (k) = 3;
+	      L->stack[i].b = OP2 (k);
+	      push (L, 'E', &i, &ok);
+	      L->stack[i].b = OP1 (k);
 	    }
 	  else
 	    {
 	      ok = FALSE;
-	      err ("Invalid symbol for ]\n");
+	      err (L, "Invalid symbol for ]\n");
 	    }
 	  break;
 
@@ -1034,7 +2933,7 @@ parse (int *rt)
 	    {
 
 	      /* empty list */
-	      L->heap[k].code = 4;
+	      CODE (k) = 4;
 	      i -= 2;
 	    }
 	  else
@@ -1046,123 +2945,128 @@ parse (int *rt)
 
 		case '[':
 
-		  L->heap[k].u.op2 = get_node ();
-		  L->heap[k].op1 = get_node ();
-		  L->heap[k].code = 3;
-		  push (']', &i, &ok);
-		  L->stack[i].b = L->heap[k].u.op2;
-		  push ('N', &i, &ok);
-		  L->stack[i].b = L->heap[k].op1;
+		  child = get_node (L);
+		  OP2 (k) = child;
+		  child = get_node (L);
+		  OP1 (k) = child;
+		  CODE (k) = 3;
+		  push (L, ']', &i, &ok);
+		  L->stack[i].b = OP2 (k);
+		  push (L, 'N', &i, &ok);
+		  L->stack[i].b = OP1 (k);
 		  break;
 
 		case '\\':	/* \ prefix */
 
-		  ch = get_token (&whole, &decimal);
+		  ch = get_token (L, &whole, &decimal);
 		  if (ch != 'a')
-		    err ("Error \\ \n");
+		    err (L, "Error \\ \n");
 		  else
 		    {
 		      i++;	/* undo pop */
-		      L->heap[k].code = 1;
-		      L->heap[k].op1 = whole;
-		      L->heap[k].u.op2 = get_node ();
-		      L->stack[i].b = L->heap[k].u.op2;
-		      add_identifier (whole);
-		      ch = get_token (&whole, &decimal);
+		      CODE (k) = 1;
+		      OP1 (k) = whole;
+		      child = get_node (L);
+		      OP2 (k) = child;
+		      L->stack[i].b = OP2 (k);
+		      add_identifier (L, whole);
+		      ch = get_token (L, &whole, &decimal);
 		      if (ch != '.')
-			err ("dot is missing\n");
+			err (L, "dot is missing\n");
 		    }
 		  break;
 
 		case '(':
 
 		  i++;		/* undo pop */
-		  L->heap[k].op1 = get_node ();
-		  L->heap[k].u.op2 = get_node ();
-		  L->heap[k].code = 2;
-		  L->stack[i].b = L->heap[k].u.op2;
-		  push (')', &i, &ok);
-		  push ('E', &i, &ok);
-		  L->stack[i].b = L->heap[k].op1;
+		  child = get_node (L);
+		  OP1 (k) = child;
+		  child = get_node (L);
+		  OP2 (k) = child;
+		  CODE (k) = 2;
+		  L->stack[i].b = OP2 (k);
+		  push (L, ')', &i, &ok);
+		  push (L, 'E', &i, &ok);
+		  L->stack[i].b = OP1 (k);
 		  break;
 
 		case 'a':	/* identifier */
 
-		  L->heap[k].code = 11;
-		  L->heap[k].op1 = whole;
-		  L->heap[k].u.op2 = L->table[whole].key;
+		  CODE (k) = 11;
+		  OP1 (k) = whole;
+		  OP2 (k) = L->table[whole].key;
 		  if (L->table[whole].key == 0)
-		    add_identifier (whole);
+		    add_identifier (L, whole);
 		  break;
 
 		case 'i':	/* integer */
 
-		  L->heap[k].code = 9;
-		  L->heap[k].u.op2 = whole;
+		  CODE (k) = 9;
+		  OP2 (k) = whole;
 		  break;
 
 		case 'r':	/* real constant */
 
-		  L->heap[k].code = 10;
-		  L->heap[k].u.alt = decimal;
+		  CODE (k) = 10;
+		  ALT (k) = decimal;
 		  break;
 
 		case '?':
 
-		  L->heap[k].code = 5;
+		  CODE (k) = 5;
 		  break;
 
 		case '^':
 
-		  L->heap[k].code = 6;
+		  CODE (k) = 6;
 		  break;
 
 		case '~':
 
-		  L->heap[k].code = 7;
+		  CODE (k) = 7;
 		  break;
 
 		case '&':
 
-		  L->heap[k].code = 8;
+		  CODE (k) = 8;
 		  break;
 
 		case '+':
 
-		  L->heap[k].code = 15;
-		  L->heap[k].u.op2 = 1;
+		  CODE (k) = 15;
+		  OP2 (k) = 1;
 		  break;
 
 		case '-':
 
-		  L->heap[k].code = 15;
-		  L->heap[k].u.op2 = 2;
+		  CODE (k) = 15;
+		  OP2 (k) = 2;
 		  break;
 
 		case '*':
 
-		  L->heap[k].code = 15;
-		  L->heap[k].u.op2 = 3;
+		  CODE (k) = 15;
+		  OP2 (k) = 3;
 		  break;
 
 		case '/':
 
-		  L->heap[k].code = 15;
-		  L->heap[k].u.op2 = 4;
+		  CODE (k) = 15;
+		  OP2 (k) = 4;
 		  break;
 
 		case '<':
 		case '=':
 		case '>':
 
-		  L->heap[k].code = 16;
-		  L->heap[k].u.op2 = whole;
+		  CODE (k) = 16;
+		  OP2 (k) = whole;
 		  break;
 
 		default:
 
 		  ok = FALSE;
-		  err ("Undefined Symbol\n");
+		  err (L, "Undefined Symbol\n");
 		  break;
 		}		/* switch on ch */
 	    }
@@ -1174,39 +3078,38 @@ parse (int *rt)
 
 	}			/* switch on L->stack[i].a */
 
-      ch = get_token (&whole, &decimal);
+      ch = get_token (L, &whole, &decimal);
 
     }				/* while */
 
   if ((!ok) || (ch != ';'))
-    err ("Illegal Expression\n");
+    err (L, "Illegal Expression\n");
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-push (char item, int *top, boolean * ok)
+push (interpreter * L, char item, int *top, boolean * ok)
 {
   if (*top < L->parms->stack_size)
     L->stack[++(*top)].a = item;
   else
     {
       *ok = FALSE;
-      err ("parser stack overflow.\n");
+      err (L, "parser stack overflow.\n");
     }
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-add_identifier (int n)
+add_identifier (interpreter * L, int n)
 {
-  register int i;
-
-  for (i = 1; i <= L->n_identifiers; i++)
-    if (L->identifiers[i] == n)
-      return;
-  L->identifiers[++L->n_identifiers] = n;
+  if (!(L->symbol_mark[n] & SYM_LISTED))
+    {
+      L->symbol_mark[n] |= SYM_LISTED;
+      L->identifiers[++L->n_identifiers] = n;
+    }
 }
 
 /*==================================================================*/
@@ -1217,60 +3120,63 @@ add_identifier (int n)
  */
 
 PRIVATE boolean
-not_free (int id, int point)
+not_free (interpreter * L, int id, int point)
 {
-  static int trace[SIZE + 1];
+  int *trace;
   boolean move;
   boolean nf;
+  boolean cached;
   int top;
-  int self;
+
+  cached = L->fv && (id < 0 || id > L->reserved);
+  if (cached)
+    {
+      free_variables (L, point);
+      if (fv_lacks (L, point, id))
+	return TRUE;
+    }
 
   nf = TRUE;
   move = TRUE;
   top = 0;
-  self = point;
+  trace = L->trace.item;
+  new_epoch (L);
 
   while (move)
     {
-      if (L->heap[point].marker)
+      if (VISITED (point) || (cached && fv_lacks (L, point, id)))
 	point = back_up (&top, &move, trace);
       else
 	{
-	  L->heap[point].marker = TRUE;
+	  VISIT (point);
 
-	  switch (L->heap[point].code)
+	  switch (CODE (point))
 	    {
 
 	    case 0:		/* ---- indirection ---- */
 
-	      point = r_child (point);
+	      point = r_child (L, point);
 	      break;
 
 	    case 1:		/* ---- abstraction ---- */
 
-	      if (id == L->heap[point].op1)
+	      if (id == OP1 (point))
 		point = back_up (&top, &move, trace);
 	      else
-		point = r_child (point);
+		point = r_child (L, point);
 	      break;
 
 	    case 2:
 	    case 3:		/* ---- application or list ---- */
 
-	      if (top < SIZE)
-		trace[++top] = r_child (point);
-	      else
-		{
-		  move = FALSE;
-		  err ("not_free(): trace overflow.\n");
-		  longjmp (LONGJUMP, 1);
-		}
-	      point = l_child (point);
+	      trace = stack_room (&L->trace, top);
+	      trace[++top] = r_child (L, point);
+	      point = l_child (L, point);
 	      break;
 
 	    case 11:		/* ---- variable ---- */
 
-	      if (id == L->heap[point].op1)
+	      if (id == OP1 (point))
 		{
 		  nf = FALSE;
 		  move = FALSE;
@@ -1282,7 +3188,7 @@ not_free (int id, int point)
 	    default:
 
 	      /*
-	       * if (L->heap[point].code < 0) point = r_child(point);
+	       * if (CODE (point) < 0) point = r_child(point);
 	       * else 
 	       */
 
@@ -1293,64 +3199,161 @@ not_free (int id, int point)
 	}			/* else */
     }				/* while */
 
-  top = 0;			/* restore the marker */
-  point = self;
-  move = TRUE;
+  return nf;
+}
 
-  while (move)
+/*------------------------------------------------------------------*/
+
+/*
+ * free-variable cache (parms->free_var_cache): the set of identifiers
+ * not_free() could find below a node, kept inline for up to FV_IDS ids.
+ * Sets are computed lazily and never updated.  Every rewrite in
+ * reduce() leaves the free variables of the rewritten node the same or
+ * fewer, so a stale set is still a superset and "id not in set" is an
+ * exact answer.  The exceptions are TRUE/FALSE and the other built-in
+ * ids that arithmetic and relations conjure up, hence not_free() does
+ * not consult the cache for ids up to L->reserved.  Renaming nodes and
+ * cycles make a set FV_MANY.
+ */
+
+PRIVATE fv_set *
+free_variables (interpreter * L, int root)
+{
+  int *track;
+  int point;
+  int child[2];
+  int n_child;
+  int top;
+  int i;
+
+  if (L->fv[root].n >= 0)
+    return &L->fv[root];
+
+  top = 0;
+  track = L->track.item;
+  track[++top] = root;
+
+  while (top > 0)
     {
-      if (!L->heap[point].marker)
-	point = back_up (&top, &move, trace);
-      else
+      point = track[top];
+      if (L->fv[point].n >= 0)
 	{
-	  L->heap[point].marker = FALSE;
+	  top--;
+	  continue;
+	}
 
-	  switch (L->heap[point].code)
-	    {
+      n_child = 0;
+      switch (CODE (point))
+	{
+	case 0:
+	case 1:
+	  child[n_child++] = r_child (L, point);
+	  break;
+	case 2:
+	case 3:
+	  child[n_child++] = l_child (L, point);
+	  child[n_child++] = r_child (L, point);
+	  break;
+	}
 
-	    case 0:		/* ---- indirection ---- */
+      if (L->fv[point].n == FV_UNKNOWN)
+	{			/* first visit: descend */
+	  L->fv[point].n = FV_BUSY;
+	  for (i = 0; i < n_child; i++)
+	    if (L->fv[child[i]].n == FV_UNKNOWN)
+	      {
+		track = stack_room (&L->track, top);
+		track[++top] = child[i];
+	      }
+	  if (track[top] != point)
+	    continue;
+	}
 
-	      point = r_child (point);
-	      break;
+      fv_combine (L, point);	/* second visit: children are done */
+      top--;
+    }
 
-	    case 1:		/* ---- abstraction ---- */
+  return &L->fv[root];
+}
 
-	      if (id == L->heap[point].op1)
-		point = back_up (&top, &move, trace);
-	      else
-		point = r_child (point);
-	      break;
+/*------------------------------------------------------------------*/
 
-	    case 2:
-	    case 3:		/* ---- application or list ---- */
+PRIVATE void
+fv_combine (interpreter * L, int point)
+{
+  fv_set *set;
+  fv_set *sub;
+  int code;
+  int side;
+  int i, j;
+
+  set = &L->fv[point];
+  code = CODE (point);
+  set->n = 0;
+
+  if (code == 11)
+    set->id[set->n++] = OP1 (point);
+  else if (code < 0)
+    set->n = FV_MANY;
+  else if (code <= 3)
+    for (side = 0; side < 2 && set->n != FV_MANY; side++)
+      {
+	if (code < 2 && side == 0)
+	  continue;		/* one child only */
+	sub = &L->fv[side ? r_child (L, point) : l_child (L, point)];
+	if (sub->n < 0 || sub->n == FV_MANY)
+	  {			/* a cycle, or too many */
+	    set->n = FV_MANY;
+	    break;
+	  }
+	for (i = 0; i < sub->n; i++)
+	  {
+	    if (code == 1 && sub->id[i] == OP1 (point))
+	      continue;		/* bound here */
+	    for (j = 0; j < set->n && set->id[j] != sub->id[i]; j++);
+	    if (j < set->n)
+	      continue;
+	    if (set->n == FV_IDS)
+	      {
+		set->n = FV_MANY;
+		break;
+	      }
+	    set->id[set->n++] = sub->id[i];
+	  }
+      }
+}
 
-	      trace[++top] = r_child (point);
-	      point = l_child (point);
-	      break;
+/*------------------------------------------------------------------*/
 
-	    case 11:		/* ---- variable ---- */
+/* TRUE if the cached set of point is known not to contain id */
 
-	      if (id == L->heap[point].op1)
-		move = FALSE;
-	      else
-		point = back_up (&top, &move, trace);
-	      break;
+PRIVATE boolean
+fv_lacks (interpreter * L, int point, int id)
+{
+  fv_set *set;
+  int i;
 
-	    default:
+  set = &L->fv[point];
+  if (set->n < 0 || set->n > FV_IDS)
+    return FALSE;
+  for (i = 0; i < set->n; i++)
+    if (set->id[i] == id)
+      return FALSE;
+  return TRUE;
+}
 
-	      /*
-	       * if (L->heap[point].code < 0) point = r_child(point);
-	       * else 
-	       */
+/*------------------------------------------------------------------*/
 
-	      point = back_up (&top, &move, trace);
-	      break;
+/* recurve() lets free variables grow: drop every cached set */
 
-	    }			/* switch */
-	}			/* else */
-    }				/* while */
+PRIVATE void
+forget_free_variables (interpreter * L)
+{
+  register int i;
 
-  return nf;
+  if (L->fv)
+    for (i = 0; i <= L->heap_size; i++)
+      L->fv[i].n = FV_UNKNOWN;
 }
 
 /*------------------------------------------------------------------*/
@@ -1370,6 +3373,26 @@ back_up (int *top, boolean * move, int *trace)
     *move = FALSE;
 }
 
+/*------------------------------------------------------------------*/
+
+/*
+ * makes room for one more item on a traversal stack, doubling it when
+ * full; returns the (possibly moved) item array.
+ */
+
+PRIVATE int *
+stack_room (scratch * s, int top)
+{
+  if (top >= s->size)
+    {
+      s->size *= 2;
+      s->item = (int *) realloc (s->item, sizeof (int) * (s->size + 1));
+      if (s->item == NULL)
+	nrerror ("stack_room: allocation failure");
+    }
+  return s->item;
+}
+
 /*==================================================================*/
 
 /*  
@@ -1378,9 +3401,9 @@ back_up (int *top, boolean * move, int *trace)
  */
 
 PRIVATE void
-recurve (int id, int point)
+recurve (interpreter * L, int id, int point)
 {
-  static int trace[SIZE + 1];
+  int *trace;
   boolean move;
   int top;
   int self;
@@ -1388,50 +3411,47 @@ recurve (int id, int point)
   move = TRUE;
   top = 0;
   self = point;
+  trace = L->trace.item;
+  new_epoch (L);
 
   while (move)
     {
-      if (L->heap[point].marker)
+      if (VISITED (point))
 	point = back_up (&top, &move, trace);
       else
 	{
-	  L->heap[point].marker = TRUE;
+	  VISIT (point);
 
-	  switch (L->heap[point].code)
+	  switch (CODE (point))
 	    {
 
 	    case 0:		/* ---- indirection ---- */
 
-	      point = r_child (point);
+	      point = r_child (L, point);
 	      break;
 
 	    case 1:		/* ---- abstraction ---- */
 
-	      if (id == L->heap[point].op1)
+	      if (id == OP1 (point))
 		point = back_up (&top, &move, trace);
 	      else
-		point = r_child (point);
+		point = r_child (L, point);
 	      break;
 
 	    case 2:
 	    case 3:		/* ---- application or list ---- */
 
-	      if (top < SIZE)
-		trace[++top] = r_child (point);
-	      else
-		{
-		  move = FALSE;
-		  err ("recurve(): trace overflow.\n");
-		}
-	      point = l_child (point);
+	      trace = stack_room (&L->trace, top);
+	      trace[++top] = r_child (L, point);
+	      point = l_child (L, point);
 	      break;
 
 	    case 11:		/* ---- variable ---- */
 
-	      if (id == L->heap[point].op1)
+	      if (id == OP1 (point))
 		{
-		  L->heap[point].code = 0;
-		  L->heap[point].u.op2 = self;
+		  CODE (point) = 0;
+		  OP2 (point) = self;
 		}
 	      else
 		point = back_up (&top, &move, trace);
@@ -1445,62 +3465,17 @@ recurve (int id, int point)
 	    }			/* switch */
 	}			/* else */
     }				/* while */
-
-  top = 0;			/* restore the marker */
-  point = self;
-  move = TRUE;
-
-  while (move)
-    {
-      if (!L->heap[point].marker)
-	point = back_up (&top, &move, trace);
-      else
-	{
-	  L->heap[point].marker = FALSE;
-
-	  switch (L->heap[point].code)
-	    {
-
-	    case 0:		/* ---- indirection ---- */
-
-	      point = r_child (point);
-	      break;
-
-	    case 1:		/* ---- abstraction ---- */
-
-	      if (id == L->heap[point].op1)
-		point = back_up (&top, &move, trace);
-	      else
-		point = r_child (point);
-	      break;
-
-	    case 2:
-	    case 3:		/* ---- application or list ---- */
-
-	      trace[++top] = r_child (point);
-	      point = l_child (point);
-	      break;
-
-	    default:
-
-	      point = back_up (&top, &move, trace);
-	      break;
-
-	    }			/* switch */
-	}			/* else */
-    }				/* while */
 }
 
 /*==================================================================*/
 
 PRIVATE int
-reduce (int rt, heap_node * nd)
+reduce (interpreter * L, int rt)
 {
 
   if (!L->resume)
     {
       L->done = FALSE;
-      L->node = nd;
       L->sys_var = 0;
       L->top = 0;
       L->iterate = TRUE;
@@ -1511,15 +3486,6 @@ reduce (int rt, heap_node * nd)
   if (L->error.symbol_table_overflow)
     return FALSE;
 
-  /* abort reduction in case of overflow in not_free() */
-
-  if (setjmp (LONGJUMP))
-    {
-      L->iterate = FALSE;
-      L->error.not_free_overflow_hits++;
-      L->error.not_free_overflow = TRUE;
-    }
-
   while (L->iterate)
     {
 
@@ -1533,93 +3499,93 @@ reduce (int rt, heap_node * nd)
       L->cycles++;
       L->reductions++;
 
-      switch (L->node[L->n1].code)
+      switch (CODE (L->n1))
 	{
 
 	case 0:		/* ---- indirection ---- */
 
 	  L->reductions--;
 
-	  L->n1 = r_child (L->n1);
+	  L->n1 = r_child (L, L->n1);
 	  break;
 
 	case 1:		/* ---- abstraction ---- */
 
 	  L->reductions--;
 
-	  L->n2 = r_child (L->n1);
-	  if (L->node[L->n2].code == 3)
+	  L->n2 = r_child (L, L->n1);
+	  if (CODE (L->n2) == 3)
 	    {
-	      gamma2 ();
+	      gamma2 (L);
 	    }
-	  else if (L->node[L->n2].code == 4)
-	    gamma0 ();
+	  else if (CODE (L->n2) == 4)
+	    gamma0 (L);
 	  else
 	    L->n1 = L->n2;
 	  break;
 
 	case 2:		/* ---- application ---- */
 
-	  L->n2 = l_child (L->n1);
-	  L->n4 = r_child (L->n1);
+	  L->n2 = l_child (L, L->n1);
+	  L->n4 = r_child (L, L->n1);
 
-	  switch (L->node[L->n2].code)
+	  switch (CODE (L->n2))
 	    {
 
 	    case 1:		/* ---- beta-redex ---- */
 
-	      L->n3 = r_child (L->n2);
+	      L->n3 = r_child (L, L->n2);
 
-	      switch (L->node[L->n3].code)
+	      switch (CODE (L->n3))
 		{
 
 		case 1:
 
-		  if (not_free (L->node[L->n2].op1, L->n3))
-		    beta2 ();
-		  else if (not_free (L->node[L->n3].op1, L->n4))
+		  if (not_free (L, OP1 (L->n2), L->n3))
+		    beta2 (L);
+		  else if (not_free (L, OP1 (L->n3), L->n4))
 		    {
-		      beta3p ();
+		      beta3p (L);
 		    }
 		  else
 		    {
-		      beta3 ();
+		      beta3 (L);
 		    }
 		  break;
 
 		case 2:
 
-		  if (not_free (L->node[L->n2].op1, l_child (L->n3)))
+		  if (not_free (L, OP1 (L->n2), l_child (L, L->n3)))
 		    {
-		      if (not_free (L->node[L->n2].op1, r_child (L->n3)))
-			beta2 ();
+		      if (not_free (L, OP1 (L->n2), r_child (L, L->n3)))
+			beta2 (L);
 		      else
 			{
-			  beta4p ();
+			  beta4p (L);
 			}
 		    }
 		  else
 		    {
-		      beta4 ();
+		      beta4 (L);
 		    }
 		  break;
 
 		case 11:
 
-		  if (L->node[L->n2].op1 != L->node[L->n3].op1)
-		    beta2 ();
+		  if (OP1 (L->n2) != OP1 (L->n3))
+		    beta2 (L);
 		  else
-		    beta1 ();
+		    beta1 (L);
 		  break;
 
 		default:
 
-		  if (not_free (L->node[L->n2].op1, L->n3))
-		    beta2 ();
+		  if (not_free (L, OP1 (L->n2), L->n3))
+		    beta2 (L);
 		  else
 		    {
 		      L->reductions--;
-		      store (L->n1);
+		      store (L, L->n1);
 		      L->n1 = L->n2;
 		    }
 		  break;
@@ -1628,47 +3594,47 @@ reduce (int rt, heap_node * nd)
 
 	    case 2:		/* ---- double application ---- */
 
-	      L->n3 = l_child (L->n2);
+	      L->n3 = l_child (L, L->n2);
 
-	      switch (L->node[L->n3].code)
+	      switch (CODE (L->n3))
 		{
 
 		case 8:	/* ---- cons operator & ---- */
 
-		  L->node[L->n1].code = 3;
-		  L->node[L->n1].op1 = r_child (L->n2);
+		  CODE (L->n1) = 3;
+		  OP1 (L->n1) = r_child (L, L->n2);
 		  L->changed = TRUE;
-		  go_back ();
+		  go_back (L);
 		  break;
 
 		case 11:	/* ---- binary operator ---- */
 
-		  if (L->node[L->n3].u.op2 > 20)
+		  if (OP2 (L->n3) > 20)
 		    {
-		      binary (L->node[L->n3].u.op2);
+		      binary (L, OP2 (L->n3));
 		    }
 		  else
 		    {
 		      L->reductions--;
-		      store (L->n1);
+		      store (L, L->n1);
 		      L->n1 = L->n2;
 		    }
 		  break;
 
 		case 15:	/* ---- {+, -, *, or /} ---- */
 
-		  arithmetics (L->node[L->n3].u.op2);
+		  arithmetics (L, OP2 (L->n3));
 		  break;
 
 		case 16:	/* ---- {=, <, >, <=, >=, <>} ---- */
 
-		  relation (L->node[L->n3].u.op2);
+		  relation (L, OP2 (L->n3));
 		  break;
 
 		default:
 
 		  L->reductions--;
-		  store (L->n1);
+		  store (L, L->n1);
 		  L->n1 = L->n2;
 		  break;
 		}
@@ -1676,108 +3642,108 @@ reduce (int rt, heap_node * nd)
 
 	    case 3:
 
-	      gamma1 ();
+	      gamma1 (L);
 	      break;
 
 	    case 4:
 
-	      gamma0 ();
+	      gamma0 (L);
 	      break;
 
 	    case 5:		/* ---- Y combinator ---- */
 
-	      L->k1 = get_node ();
-	      L->node[L->k1].code = 2;
-	      L->node[L->k1].op1 = L->n2;
-	      L->node[L->k1].u.op2 = L->n4;
-	      L->node[L->n1].op1 = L->n4;
-	      L->node[L->n1].u.op2 = L->k1;
+	      L->k1 = get_node (L);
+	      CODE (L->k1) = 2;
+	      OP1 (L->k1) = L->n2;
+	      OP2 (L->k1) = L->n4;
+	      OP1 (L->n1) = L->n4;
+	      OP2 (L->n1) = L->k1;
 	      break;
 
 	    case 6:
 	    case 7:		/* ---- head or tail ---- */
 
-	      if (L->node[L->n4].code == 4)
-		gamma0 ();
-	      else if (L->node[L->n4].code == 3)
+	      if (CODE (L->n4) == 4)
+		gamma0 (L);
+	      else if (CODE (L->n4) == 3)
 		{
-		  L->node[L->n1].code = 0;
-		  if (L->node[L->n2].code == 6)
-		    L->node[L->n1].u.op2 = l_child (L->n4);
+		  CODE (L->n1) = 0;
+		  if (CODE (L->n2) == 6)
+		    OP2 (L->n1) = l_child (L, L->n4);
 		  else
-		    L->node[L->n1].u.op2 = r_child (L->n4);
+		    OP2 (L->n1) = r_child (L, L->n4);
 		  L->changed = TRUE;
-		  go_back ();
+		  go_back (L);
 		}
-	      else if (L->node[L->n4].code < 3)
+	      else if (CODE (L->n4) < 3)
 		{
 		  L->reductions--;
-		  store (L->n1);
+		  store (L, L->n1);
 		  L->n1 = L->n4;
 		}
 	      else
 		{
 		  L->iterate = FALSE;
 		  L->error.wrong_expr_for_hd_tl += 1;
-		  err ("Wrong Expression for Head/Tail\n");
+		  err (L, "Wrong Expression for Head/Tail\n");
 		}
 	      break;
 
 	    case 9:		/* ---- select operation ---- */
 
-	      if (L->node[L->n4].code == 3)
+	      if (CODE (L->n4) == 3)
 		{
-		  if (L->node[L->n2].u.op2 == 1)
+		  if (OP2 (L->n2) == 1)
 		    {
-		      L->node[L->n1].code = 0;
-		      L->node[L->n1].op1 = 0;
-		      L->node[L->n1].u.op2 = l_child (L->n4);
+		      CODE (L->n1) = 0;
+		      OP1 (L->n1) = 0;
+		      OP2 (L->n1) = l_child (L, L->n4);
 		      L->changed = TRUE;
-		      go_back ();
+		      go_back (L);
 		    }
-		  else if (L->node[L->n2].u.op2 > 1)
+		  else if (OP2 (L->n2) > 1)
 		    {
-		      L->position = L->node[L->n2].u.op2 - 1;
-		      L->rest = r_child (L->n4);
-		      while ((L->position > 1) && (L->node[L->rest].code == 3))
+		      L->position = OP2 (L->n2) - 1;
+		      L->rest = r_child (L, L->n4);
+		      while ((L->position > 1) && (CODE (L->rest) == 3))
 			{
 			  L->position--;
-			  L->rest = r_child (L->rest);
+			  L->rest = r_child (L, L->rest);
 			}
-		      L->k1 = get_node ();
-		      L->node[L->k1].code = 9;
-		      L->node[L->k1].u.op2 = L->position;
-		      L->node[L->k1].op1 = 0;
-		      L->node[L->n1].op1 = L->k1;
-		      L->node[L->n1].u.op2 = L->rest;
+		      L->k1 = get_node (L);
+		      CODE (L->k1) = 9;
+		      OP2 (L->k1) = L->position;
+		      OP1 (L->k1) = 0;
+		      OP1 (L->n1) = L->k1;
+		      OP2 (L->n1) = L->rest;
 		    }
 		}
-	      else if (L->node[L->n4].code < 3)
+	      else if (CODE (L->n4) < 3)
 		{
 		  L->reductions--;
-		  store (L->n1);
+		  store (L, L->n1);
 		  L->n1 = L->n4;
 		}
 	      else
 		{
 		  L->iterate = FALSE;
 		  L->error.wrong_expr_for_selection += 1;
-		  err ("Wrong Expression for Selection\n");
+		  err (L, "Wrong Expression for Selection\n");
 		}
 	      break;
 
 	    case 11:
 
-	      if ((L->node[L->n2].op1 > 0) && (L->node[L->n2].u.op2 > 0))
+	      if ((OP1 (L->n2) > 0) && (OP2 (L->n2) > 0))
 		{
-		  if (L->node[L->n2].u.op2 < 21)
+		  if (OP2 (L->n2) < 21)
 		    {
-		      unary (L->node[L->n2].u.op2);
+		      unary (L, OP2 (L->n2));
 		    }
 		  else
 		    {
 		      L->reductions--;
-		      go_back ();	/* binary operator */
+		      go_back (L);	/* binary operator */
 		      if (L->empty)
 			L->n1 = L->n4;
 		    }
@@ -1794,7 +3760,7 @@ reduce (int rt, heap_node * nd)
 	    case 16:
 
 	      L->reductions--;
-	      go_back ();
+	      go_back (L);
 	      if (L->empty)
 		L->n1 = L->n4;
 	      break;
@@ -1803,7 +3769,7 @@ reduce (int rt, heap_node * nd)
 
 	      L->iterate = FALSE;
 	      L->error.wrong_operator += 1;
-	      err ("Wrong Operator\n");
+	      err (L, "Wrong Operator\n");
 	      break;
 	    }
 	  break;		/* end of application */
@@ -1811,20 +3777,20 @@ reduce (int rt, heap_node * nd)
 	case 3:		/* ---- list structure ---- */
 
 	  L->reductions--;
-	  store (L->n1);
-	  L->n1 = l_child (L->n1);
+	  store (L, L->n1);
+	  L->n1 = l_child (L, L->n1);
 	  break;
 
 	default:
 
-	  if (L->node[L->n1].code < 0)
+	  if (CODE (L->n1) < 0)
 	    {
-	      alpha ();		/* renaming */
+	      alpha (L);		/* renaming */
 	    }
 	  else
 	    {
 	      L->reductions--;
-	      go_back ();
+	      go_back (L);
 	      if (L->empty)
 		{
 		  L->iterate = FALSE;
@@ -1833,7 +3799,7 @@ reduce (int rt, heap_node * nd)
 	      else if (L->changed)
 		L->changed = FALSE;
 	      else
-		L->n1 = r_child (L->n1);
+		L->n1 = r_child (L, L->n1);
 	    }
 	  break;
 	}
@@ -1854,7 +3820,7 @@ reduce (int rt, heap_node * nd)
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-store (int index)
+store (interpreter * L, int index)
 {
   if (L->top < L->parms->stack_size)
     L->path[++L->top] = index;
@@ -1862,14 +3828,14 @@ store (int index)
     {
       L->iterate = FALSE;
       L->error.path_overflow_in_reduce += 1;
-      err ("Path Overflow in Reduce.\n");
+      err (L, "Path Overflow in Reduce.\n");
     }
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-go_back (void)
+go_back (interpreter * L)
 {
   if (L->top > 0)
     {
@@ -1883,66 +3849,66 @@ go_back (void)
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-alpha (void)
+alpha (interpreter * L)
 {
-  L->n2 = r_child (L->n1);
-  if (not_free (L->node[L->n1].op1, L->n2))
+  L->n2 = r_child (L, L->n1);
+  if (not_free (L, OP1 (L->n1), L->n2))
     {				/* alpha2 */
-      L->node[L->n1].code = 0;
-      go_back ();
+      CODE (L->n1) = 0;
+      go_back (L);
       if (L->empty)
 	{
 	  L->iterate = FALSE;
 	  L->error.wrong_renaming += 1;
-	  err ("Wrong Renaming\n");
+	  err (L, "Wrong Renaming\n");
 	}
     }
   else
     {
 
-      switch (L->node[L->n2].code)
+      switch (CODE (L->n2))
 	{
 	case 1:		/* alpha3 */
 
-	  L->k1 = get_node ();
-	  L->node[L->k1].code = L->node[L->n1].code;
-	  L->node[L->k1].op1 = L->node[L->n1].op1;
-	  L->node[L->k1].u.op2 = r_child (L->n2);
-	  L->node[L->n1].code = 1;
-	  L->node[L->n1].op1 = L->node[L->n2].op1;
-	  L->node[L->n1].u.op2 = L->k1;
+	  L->k1 = get_node (L);
+	  CODE (L->k1) = CODE (L->n1);
+	  OP1 (L->k1) = OP1 (L->n1);
+	  OP2 (L->k1) = r_child (L, L->n2);
+	  CODE (L->n1) = 1;
+	  OP1 (L->n1) = OP1 (L->n2);
+	  OP2 (L->n1) = L->k1;
 	  L->n1 = L->k1;
 	  break;
 
 	case 2:
 	case 3:		/* alpha4 and alpha5 */
 
-	  L->k1 = get_node ();
-	  L->node[L->k1].code = L->node[L->n1].code;
-	  L->node[L->k1].op1 = L->node[L->n1].op1;
-	  L->node[L->k1].u.op2 = l_child (L->n2);
-	  L->node[L->n1].code = L->node[L->n2].code;
-	  L->node[L->n1].op1 = L->k1;
-	  L->k2 = get_node ();
-	  L->node[L->k2].code = L->node[L->k1].code;
-	  L->node[L->k2].op1 = L->node[L->k1].op1;
-	  L->node[L->k2].u.op2 = r_child (L->n2);
-	  L->node[L->n1].u.op2 = L->k2;
-	  store (L->k2);
+	  L->k1 = get_node (L);
+	  CODE (L->k1) = CODE (L->n1);
+	  OP1 (L->k1) = OP1 (L->n1);
+	  OP2 (L->k1) = l_child (L, L->n2);
+	  CODE (L->n1) = CODE (L->n2);
+	  OP1 (L->n1) = L->k1;
+	  L->k2 = get_node (L);
+	  CODE (L->k2) = CODE (L->k1);
+	  OP1 (L->k2) = OP1 (L->k1);
+	  OP2 (L->k2) = r_child (L, L->n2);
+	  OP2 (L->n1) = L->k2;
+	  store (L, L->k2);
 	  L->n1 = L->k1;
 	  break;
 
 	case 11:		/* alpha1 */
 
-	  L->node[L->n1].op1 = L->node[L->n1].code;
-	  L->node[L->n1].code = 11;
-	  L->node[L->n1].u.op2 = 0;
-	  go_back ();
+	  OP1 (L->n1) = CODE (L->n1);
+	  CODE (L->n1) = 11;
+	  OP2 (L->n1) = 0;
+	  go_back (L);
 	  if (L->empty)
 	    {
 	      L->iterate = FALSE;
 	      L->error.wrong_renaming += 1;
-	      err ("Wrong Renaming\n");
+	      err (L, "Wrong Renaming\n");
 	    }
 	  break;
 
@@ -1953,48 +3919,48 @@ alpha (void)
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-beta1 (void)
+beta1 (interpreter * L)
 {
-  L->node[L->n1].code = 0;
+  CODE (L->n1) = 0;
   L->changed = TRUE;
-  go_back ();
+  go_back (L);
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-beta2 (void)
+beta2 (interpreter * L)
 {
-  L->node[L->n1].code = 0;
-  L->node[L->n1].u.op2 = L->n3;
+  CODE (L->n1) = 0;
+  OP2 (L->n1) = L->n3;
   L->changed = TRUE;
-  go_back ();
+  go_back (L);
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-beta3 (void)
+beta3 (interpreter * L)
 {
-  L->k1 = get_node ();
-  L->node[L->k1].code = 2;
-  L->node[L->k1].op1 = L->n2;	/* temporary */
-  L->node[L->k1].u.op2 = L->n4;
+  L->k1 = get_node (L);
+  CODE (L->k1) = 2;
+  OP1 (L->k1) = L->n2;	/* temporary */
+  OP2 (L->k1) = L->n4;
   L->sys_var--;
-  L->node[L->n1].code = 1;
-  L->node[L->n1].op1 = L->sys_var;
-  L->node[L->n1].u.op2 = L->k1;
-  L->k2 = get_node ();
-  L->node[L->k2].code = 1;
-  L->node[L->k2].op1 = L->node[L->n2].op1;
-  L->node[L->k2].u.op2 = L->n3;	/* temporary */
-  L->node[L->k1].op1 = L->k2;
-  L->k3 = get_node ();
-  L->node[L->k3].code = L->sys_var;
-  L->node[L->k3].op1 = L->node[L->n3].op1;
-  L->node[L->k3].u.op2 = r_child (L->n3);
-  L->node[L->k2].u.op2 = L->k3;
-  store (L->k1);
+  CODE (L->n1) = 1;
+  OP1 (L->n1) = L->sys_var;
+  OP2 (L->n1) = L->k1;
+  L->k2 = get_node (L);
+  CODE (L->k2) = 1;
+  OP1 (L->k2) = OP1 (L->n2);
+  OP2 (L->k2) = L->n3;	/* temporary */
+  OP1 (L->k1) = L->k2;
+  L->k3 = get_node (L);
+  CODE (L->k3) = L->sys_var;
+  OP1 (L->k3) = OP1 (L->n3);
+  OP2 (L->k3) = r_child (L, L->n3);
+  OP2 (L->k2) = L->k3;
+  store (L, L->k1);
   L->n1 = L->k3;
   L->changed = TRUE;
 }
@@ -2002,20 +3968,20 @@ beta3 (void)
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-beta3p (void)
-{
-  L->k1 = get_node ();
-  L->node[L->k1].code = 2;
-  L->node[L->k1].op1 = L->n2;	/* temporary */
-  L->node[L->k1].u.op2 = L->n4;
-  L->node[L->n1].code = 1;
-  L->node[L->n1].op1 = L->node[L->n3].op1;
-  L->node[L->n1].u.op2 = L->k1;
-  L->k2 = get_node ();
-  L->node[L->k2].code = 1;
-  L->node[L->k2].op1 = L->node[L->n2].op1;
-  L->node[L->k2].u.op2 = r_child (L->n3);
-  L->node[L->k1].op1 = L->k2;
+beta3p (interpreter * L)
+{
+  L->k1 = get_node (L);
+  CODE (L->k1) = 2;
+  OP1 (L->k1) = L->n2;	/* temporary */
+  OP2 (L->k1) = L->n4;
+  CODE (L->n1) = 1;
+  OP1 (L->n1) = OP1 (L->n3);
+  OP2 (L->n1) = L->k1;
+  L->k2 = get_node (L);
+  CODE (L->k2) = 1;
+  OP1 (L->k2) = OP1 (L->n2);
+  OP2 (L->k2) = r_child (L, L->n3);
+  OP1 (L->k1) = L->k2;
   L->n1 = L->k1;
   L->changed = TRUE;
 }
@@ -2023,33 +3989,33 @@ beta3p (void)
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-beta4 (void)
-{
-  L->k1 = get_node ();
-  L->node[L->k1].code = 2;
-  L->node[L->k1].op1 = L->n2;	/* temporary */
-  L->node[L->k1].u.op2 = L->n4;
-  L->node[L->n1].op1 = L->k1;
-  L->k2 = get_node ();
-  L->node[L->k2].code = 2;
-  L->node[L->k2].op1 = L->n2;	/* temporary */
-  L->node[L->k2].u.op2 = L->n4;
-  L->node[L->n1].u.op2 = L->k2;
-  L->k3 = get_node ();
-  L->node[L->k3].code = 1;
-  L->node[L->k3].op1 = L->node[L->n2].op1;
-  L->node[L->k3].u.op2 = l_child (L->n3);
-  L->node[L->k1].op1 = L->k3;
-  L->k4 = get_node ();
-  L->node[L->k4].code = 1;
-  L->node[L->k4].op1 = L->node[L->n2].op1;
-  L->node[L->k4].u.op2 = r_child (L->n3);
-  L->node[L->k2].op1 = L->k4;
-  go_back ();
+beta4 (interpreter * L)
+{
+  L->k1 = get_node (L);
+  CODE (L->k1) = 2;
+  OP1 (L->k1) = L->n2;	/* temporary */
+  OP2 (L->k1) = L->n4;
+  OP1 (L->n1) = L->k1;
+  L->k2 = get_node (L);
+  CODE (L->k2) = 2;
+  OP1 (L->k2) = L->n2;	/* temporary */
+  OP2 (L->k2) = L->n4;
+  OP2 (L->n1) = L->k2;
+  L->k3 = get_node (L);
+  CODE (L->k3) = 1;
+  OP1 (L->k3) = OP1 (L->n2);
+  OP2 (L->k3) = l_child (L, L->n3);
+  OP1 (L->k1) = L->k3;
+  L->k4 = get_node (L);
+  CODE (L->k4) = 1;
+  OP1 (L->k4) = OP1 (L->n2);
+  OP2 (L->k4) = r_child (L, L->n3);
+  OP1 (L->k2) = L->k4;
+  go_back (L);
 
   if (L->empty)
     {
-      store (L->n1);
+      store (L, L->n1);
       L->n1 = L->k1;
     }
   L->changed = TRUE;
@@ -2058,194 +4024,194 @@ beta4 (void)
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-beta4p (void)
-{
-  L->k1 = get_node ();
-  L->node[L->k1].code = 2;
-  L->node[L->k1].op1 = L->n2;	/* temporary */
-  L->node[L->k1].u.op2 = L->n4;
-  L->node[L->n1].op1 = l_child (L->n3);
-  L->node[L->n1].u.op2 = L->k1;
-  L->k2 = get_node ();
-  L->node[L->k2].code = 1;
-  L->node[L->k2].op1 = L->node[L->n2].op1;
-  L->node[L->k2].u.op2 = r_child (L->n3);
-  L->node[L->k1].op1 = L->k2;
-  go_back ();
+beta4p (interpreter * L)
+{
+  L->k1 = get_node (L);
+  CODE (L->k1) = 2;
+  OP1 (L->k1) = L->n2;	/* temporary */
+  OP2 (L->k1) = L->n4;
+  OP1 (L->n1) = l_child (L, L->n3);
+  OP2 (L->n1) = L->k1;
+  L->k2 = get_node (L);
+  CODE (L->k2) = 1;
+  OP1 (L->k2) = OP1 (L->n2);
+  OP2 (L->k2) = r_child (L, L->n3);
+  OP1 (L->k1) = L->k2;
+  go_back (L);
   L->changed = TRUE;
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-gamma0 (void)
+gamma0 (interpreter * L)
 {
-  L->node[L->n1].code = 4;
+  CODE (L->n1) = 4;
   L->changed = TRUE;
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-gamma1 (void)
-{
-  L->node[L->n1].code = 3;
-  L->k1 = get_node ();
-  L->node[L->k1].code = 2;
-  L->node[L->k1].op1 = l_child (L->n2);
-  L->node[L->k1].u.op2 = L->n2;	/* temporary */
-  L->node[L->n1].op1 = L->k1;
-  L->k2 = get_node ();
-  L->node[L->k2].code = 2;
-  L->node[L->k2].op1 = r_child (L->n2);
-  L->node[L->k2].u.op2 = L->n4;
-  L->node[L->n1].u.op2 = L->k2;
-  L->node[L->k1].u.op2 = L->n4;
-  go_back ();
+gamma1 (interpreter * L)
+{
+  CODE (L->n1) = 3;
+  L->k1 = get_node (L);
+  CODE (L->k1) = 2;
+  OP1 (L->k1) = l_child (L, L->n2);
+  OP2 (L->k1) = L->n2;	/* temporary */
+  OP1 (L->n1) = L->k1;
+  L->k2 = get_node (L);
+  CODE (L->k2) = 2;
+  OP1 (L->k2) = r_child (L, L->n2);
+  OP2 (L->k2) = L->n4;
+  OP2 (L->n1) = L->k2;
+  OP2 (L->k1) = L->n4;
+  go_back (L);
   L->changed = TRUE;
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-gamma2 (void)
-{
-  L->node[L->n1].code = 3;
-  L->k1 = get_node ();
-  L->node[L->k1].code = 1;
-  L->node[L->k1].op1 = L->node[L->n1].op1;
-  L->node[L->k1].u.op2 = l_child (L->n2);
-  L->node[L->n1].op1 = L->k1;
-  L->k2 = get_node ();
-  L->node[L->k2].code = 1;
-  L->node[L->k2].op1 = L->node[L->k1].op1;
-  L->node[L->k2].u.op2 = r_child (L->n2);
-  L->node[L->n1].u.op2 = L->k2;
-  go_back ();
+gamma2 (interpreter * L)
+{
+  L->k1 = get_node (L);
+  CODE (L->k1) = 1;
+  OP1 (L->k1) = OP1 (L->n1);
+  OP2 (L->k1) = l_child (L, L->n2);
+  CODE (L->n1) = 3;		/* not before: op1 still holds the variable */
+  OP1 (L->n1) = L->k1;
+  L->k2 = get_node (L);
+  CODE (L->k2) = 1;
+  OP1 (L->k2) = OP1 (L->k1);
+  OP2 (L->k2) = r_child (L, L->n2);
+  OP2 (L->n1) = L->k2;
+  go_back (L);
   L->changed = TRUE;
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-arithmetics (int which)
+arithmetics (interpreter * L, int which)
 {
-  L->n5 = r_child (L->n2);
+  L->n5 = r_child (L, L->n2);
 
-  if (L->node[L->n5].code == 9)
+  if (CODE (L->n5) == 9)
     {
-      if (L->node[L->n4].code == 9)
+      if (CODE (L->n4) == 9)
 	{
-	  L->node[L->n1].code = 9;
+	  CODE (L->n1) = 9;
 
 	  switch (which)
 	    {
 
 	    case 1:
-	      L->node[L->n1].u.op2 = (L->node[L->n5].u.op2 + L->node[L->n4].u.op2);
+	      OP2 (L->n1) = (OP2 (L->n5) + OP2 (L->n4));
 	      break;
 	    case 2:
-	      L->node[L->n1].u.op2 = (L->node[L->n5].u.op2 - L->node[L->n4].u.op2);
+	      OP2 (L->n1) = (OP2 (L->n5) - OP2 (L->n4));
 	      break;
 	    case 3:
-	      L->node[L->n1].u.op2 = (L->node[L->n5].u.op2 * L->node[L->n4].u.op2);
+	      OP2 (L->n1) = (OP2 (L->n5) * OP2 (L->n4));
 	      break;
 	    case 4:
-	      L->node[L->n1].u.op2 = (L->node[L->n5].u.op2 / L->node[L->n4].u.op2);
+	      OP2 (L->n1) = (OP2 (L->n5) / OP2 (L->n4));
 	      break;
 	    }
 	  L->changed = TRUE;	/* L->n1 becomes leaf node */
 	}
-      else if (L->node[L->n4].code == 10)
-	rational (1, which);
-      else if (L->node[L->n4].code == 2)
+      else if (CODE (L->n4) == 10)
+	rational (L, 1, which);
+      else if (CODE (L->n4) == 2)
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
       else
 	{
 	  L->iterate = FALSE;
 	  L->error.wrong_second_operand_for_arithmetics += 1;
-	  err ("Wrong Second Operand for Arithmetics\n");
+	  err (L, "Wrong Second Operand for Arithmetics\n");
 	}
     }
-  else if (L->node[L->n5].code == 10)
+  else if (CODE (L->n5) == 10)
     {
-      if (L->node[L->n4].code == 9)
-	rational (2, which);
-      else if (L->node[L->n4].code == 10)
-	rational (3, which);
-      else if (L->node[L->n4].code == 2)
+      if (CODE (L->n4) == 9)
+	rational (L, 2, which);
+      else if (CODE (L->n4) == 10)
+	rational (L, 3, which);
+      else if (CODE (L->n4) == 2)
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
       else
 	{
 	  L->iterate = FALSE;
 	  L->error.wrong_second_operand_for_arithmetics += 1;
-	  err ("Wrong Second Operand for Arithmetics\n");
+	  err (L, "Wrong Second Operand for Arithmetics\n");
 	}
     }
-  else if (L->node[L->n5].code == 2)
+  else if (CODE (L->n5) == 2)
     {
-      store (L->n1);
+      store (L, L->n1);
       L->n1 = L->n5;
     }
   else
     {
       L->iterate = FALSE;
       L->error.wrong_second_operand_for_arithmetics += 1;
-      err ("Wrong Second Operand for Arithmetics\n");
+      err (L, "Wrong Second Operand for Arithmetics\n");
     }
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-rational (int some, int which)
+rational (interpreter * L, int some, int which)
 {
   float x;
   float y;
 
-  L->node[L->n1].code = 10;
+  CODE (L->n1) = 10;
 
   switch (some)
     {
 
     case 1:
 
-      x = L->node[L->n5].u.op2;
-      y = L->node[L->n4].u.alt;
+      x = OP2 (L->n5);
+      y = ALT (L->n4);
       break;
 
     case 2:
 
-      x = L->node[L->n5].u.alt;
-      y = L->node[L->n4].u.op2;
+      x = ALT (L->n5);
+      y = OP2 (L->n4);
       break;
 
     case 3:
 
-      x = L->node[L->n5].u.alt;
-      y = L->node[L->n4].u.alt;
+      x = ALT (L->n5);
+      y = ALT (L->n4);
       break;
     }
   switch (which)
     {
 
     case 1:
-      L->node[L->n1].u.alt = (x + y);
+      ALT (L->n1) = (x + y);
       break;
     case 2:
-      L->node[L->n1].u.alt = (x - y);
+      ALT (L->n1) = (x - y);
       break;
     case 3:
-      L->node[L->n1].u.alt = (x * y);
+      ALT (L->n1) = (x * y);
       break;
     case 4:
-      L->node[L->n1].u.alt = (x / y);
+      ALT (L->n1) = (x / y);
       break;
     }
   L->changed = TRUE;		/* L->n1 becomes a leaf node */
@@ -2254,98 +4220,99 @@ rational (int some, int which)
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-relation (int which)
+relation (interpreter * L, int which)
 {
   boolean answer;
   boolean done;
 
   done = FALSE;
-  L->n5 = r_child (L->n2);
+  answer = FALSE;
+  L->n5 = r_child (L, L->n2);
 
-  if (L->node[L->n5].code == 9)
+  if (CODE (L->n5) == 9)
     {
-      if (L->node[L->n4].code == 9)
+      if (CODE (L->n4) == 9)
 	{
 
 	  switch (which)
 	    {
 
 	    case 0:
-	      answer = (L->node[L->n5].u.op2 == L->node[L->n4].u.op2);
+	      answer = (OP2 (L->n5) == OP2 (L->n4));
 	      break;
 	    case 1:
-	      answer = (L->node[L->n5].u.op2 < L->node[L->n4].u.op2);
+	      answer = (OP2 (L->n5) < OP2 (L->n4));
 	      break;
 	    case 2:
-	      answer = (L->node[L->n5].u.op2 > L->node[L->n4].u.op2);
+	      answer = (OP2 (L->n5) > OP2 (L->n4));
 	      break;
 	    case 3:
-	      answer = (L->node[L->n5].u.op2 <= L->node[L->n4].u.op2);
+	      answer = (OP2 (L->n5) <= OP2 (L->n4));
 	      break;
 	    case 4:
-	      answer = (L->node[L->n5].u.op2 >= L->node[L->n4].u.op2);
+	      answer = (OP2 (L->n5) >= OP2 (L->n4));
 	      break;
 	    case 5:
-	      answer = (L->node[L->n5].u.op2 != L->node[L->n4].u.op2);
+	      answer = (OP2 (L->n5) != OP2 (L->n4));
 	      break;
 	    }
 	  done = TRUE;
 	}
-      else if (L->node[L->n4].code == 10)
-	racomp (1, which, &answer, &done);
-      else if (L->node[L->n4].code == 2)
+      else if (CODE (L->n4) == 10)
+	racomp (L, 1, which, &answer, &done);
+      else if (CODE (L->n4) == 2)
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
       else
 	{
 	  L->iterate = FALSE;
 	  L->error.wrong_second_operand_for_comparison += 1;
-	  err ("Wrong Second Operand for Comparison\n");
+	  err (L, "Wrong Second Operand for Comparison\n");
 	}
     }
-  else if (L->node[L->n5].code == 10)
+  else if (CODE (L->n5) == 10)
     {
-      if (L->node[L->n4].code == 9)
-	racomp (2, which, &answer, &done);
-      else if (L->node[L->n4].code == 10)
-	racomp (3, which, &answer, &done);
-      else if (L->node[L->n4].code == 2)
+      if (CODE (L->n4) == 9)
+	racomp (L, 2, which, &answer, &done);
+      else if (CODE (L->n4) == 10)
+	racomp (L, 3, which, &answer, &done);
+      else if (CODE (L->n4) == 2)
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
       else
 	{
 	  L->iterate = FALSE;
 	  L->error.wrong_second_operand_for_comparison += 1;
-	  err ("Wrong Second Operand for Comparison\n");
+	  err (L, "Wrong Second Operand for Comparison\n");
 	}
     }
-  else if (L->node[L->n5].code == 2)
+  else if (CODE (L->n5) == 2)
     {
-      store (L->n1);
+      store (L, L->n1);
       L->n1 = L->n5;
     }
   else
     {
       L->iterate = FALSE;
       L->error.wrong_second_operand_for_comparison += 1;
-      err ("Wrong Second Operand for Comparison\n");
+      err (L, "Wrong Second Operand for Comparison\n");
     }
   if (done)
     {
-      L->node[L->n1].code = 11;
+      CODE (L->n1) = 11;
       if (answer)
 	{
-	  L->node[L->n1].op1 = locate (" TRUE      ");
-	  L->node[L->n1].u.op2 = 21;
+	  OP1 (L->n1) = SYMBOL (L, "TRUE");
+	  OP2 (L->n1) = 21;
 	}
       else
 	{
-	  L->node[L->n1].op1 = locate (" FALSE     ");
-	  L->node[L->n1].u.op2 = 22;
+	  OP1 (L->n1) = SYMBOL (L, "FALSE");
+	  OP2 (L->n1) = 22;
 	}
       L->changed = TRUE;
     }
@@ -2354,7 +4321,7 @@ relation (int which)
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-racomp (int some, int which, boolean * answer, boolean * done)
+racomp (interpreter * L, int some, int which, boolean * answer, boolean * done)
 {
   float x;
   float y;
@@ -2364,20 +4331,20 @@ racomp (int some, int which, boolean * answer, boolean * done)
 
     case 1:
 
-      x = L->node[L->n5].u.op2;
-      y = L->node[L->n4].u.alt;
+      x = OP2 (L->n5);
+      y = ALT (L->n4);
       break;
 
     case 2:
 
-      x = L->node[L->n5].u.alt;
-      y = L->node[L->n4].u.op2;
+      x = ALT (L->n5);
+      y = OP2 (L->n4);
       break;
 
     case 3:
 
-      x = L->node[L->n5].u.alt;
-      y = L->node[L->n4].u.alt;
+      x = ALT (L->n5);
+      y = ALT (L->n4);
       break;
     }
   switch (which)
@@ -2408,7 +4375,7 @@ racomp (int some, int which, boolean * answer, boolean * done)
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-unary (int which)
+unary (interpreter * L, int which)
 {
   int i;
 
@@ -2418,81 +4385,81 @@ unary (int which)
     case 1:
     case 3:			/* ---- predecessor and successor */
 
-      if (L->node[L->n4].code == 9)
+      if (CODE (L->n4) == 9)
 	{
-	  L->node[L->n1].code = 9;
-	  L->node[L->n1].u.op2 = L->node[L->n4].u.op2 + which - 2;
+	  CODE (L->n1) = 9;
+	  OP2 (L->n1) = OP2 (L->n4) + which - 2;
 	  L->changed = TRUE;	/* L->n1 becomes a leaf node */
 	}
-      else if (L->node[L->n4].code == 2)
+      else if (CODE (L->n4) == 2)
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
       else
 	{
 	  L->iterate = FALSE;
 	  L->error.wrong_operand_for_pred_succ += 1;
-	  err ("Wrong Operand for pred or succ\n");
+	  err (L, "Wrong Operand for pred or succ\n");
 	}
       break;
 
     case 2:			/* ---- Zero Test */
 
-      if (L->node[L->n4].code == 9)
+      if (CODE (L->n4) == 9)
 	{
-	  L->node[L->n1].code = 11;
-	  if (L->node[L->n4].u.op2 == 0)
+	  CODE (L->n1) = 11;
+	  if (OP2 (L->n4) == 0)
 	    {
-	      L->node[L->n1].op1 = locate (" TRUE      ");
-	      L->node[L->n1].u.op2 = 21;
+	      OP1 (L->n1) = SYMBOL (L, "TRUE");
+	      OP2 (L->n1) = 21;
 	    }
 	  else
 	    {
-	      L->node[L->n1].op1 = locate (" FALSE     ");
-	      L->node[L->n1].u.op2 = 22;
+	      OP1 (L->n1) = SYMBOL (L, "FALSE");
+	      OP2 (L->n1) = 22;
 	    }
 	  L->changed = TRUE;	/* L->n1 becomes a leaf node */
 	}
-      else if (L->node[L->n4].code == 2)
+      else if (CODE (L->n4) == 2)
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
       else
 	{
 	  L->iterate = FALSE;
 	  L->error.wrong_operand_for_zero += 1;
-	  err ("Wrong Operand for zero\n");
+	  err (L, "Wrong Operand for zero\n");
 	}
       break;
 
     case 4:			/* ---- Null Test */
 
-      if (L->node[L->n4].code == 4)
+      if (CODE (L->n4) == 4)
 	{
-	  L->node[L->n1].code = 11;
-	  L->node[L->n1].op1 = locate (" TRUE      ");
-	  L->node[L->n1].u.op2 = 21;
+	  CODE (L->n1) = 11;
+	  OP1 (L->n1) = SYMBOL (L, "TRUE");
+	  OP2 (L->n1) = 21;
 	  L->changed = TRUE;	/* leaf node */
 	}
-      else if (L->node[L->n4].code == 3)
+      else if (CODE (L->n4) == 3)
 	{
-	  L->node[L->n1].code = 11;
-	  L->node[L->n1].op1 = locate (" FALSE     ");
-	  L->node[L->n1].u.op2 = 22;
+	  CODE (L->n1) = 11;
+	  OP1 (L->n1) = SYMBOL (L, "FALSE");
+	  OP2 (L->n1) = 22;
 	  L->changed = TRUE;	/* leaf node */
 	}
-      else if ((L->node[L->n4].code == 1) || (L->node[L->n4].code == 2))
+      else if ((CODE (L->n4) == 1) || (CODE (L->n4) == 2))
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
       else
 	{
 	  L->iterate = FALSE;
 	  L->error.wrong_operand_for_null += 1;
-	  err ("Wrong Operand for null\n");
+	  err (L, "Wrong Operand for null\n");
 	}
       break;
 
@@ -2501,216 +4468,216 @@ unary (int which)
     case 7:
     case 8:			/* ---- List Arithmetic */
 
-      if (L->node[L->n4].code == 3)
-	{
-	  L->k1 = get_node ();
-	  L->node[L->k1].code = 2;
-	  L->node[L->k1].op1 = L->n2;	/* temporary */
-	  L->node[L->k1].u.op2 = l_child (L->n4);
-	  L->node[L->n1].op1 = L->k1;
-	  L->k2 = get_node ();
-	  L->node[L->k2].code = 2;
-	  L->node[L->k2].op1 = L->n2;
-	  L->node[L->k2].u.op2 = r_child (L->n4);
-	  L->node[L->n1].u.op2 = L->k2;
-	  L->k3 = get_node ();
-	  L->node[L->k3].code = 15;
-	  L->node[L->k3].u.op2 = which - 4;
-	  L->node[L->k1].op1 = L->k3;
+      if (CODE (L->n4) == 3)
+	{
+	  L->k1 = get_node (L);
+	  CODE (L->k1) = 2;
+	  OP1 (L->k1) = L->n2;	/* temporary */
+	  OP2 (L->k1) = l_child (L, L->n4);
+	  OP1 (L->n1) = L->k1;
+	  L->k2 = get_node (L);
+	  CODE (L->k2) = 2;
+	  OP1 (L->k2) = L->n2;
+	  OP2 (L->k2) = r_child (L, L->n4);
+	  OP2 (L->n1) = L->k2;
+	  L->k3 = get_node (L);
+	  CODE (L->k3) = 15;
+	  OP2 (L->k3) = which - 4;
+	  OP1 (L->k1) = L->k3;
 	  if ((which == 6) || (which == 8))
 	    {
-	      L->k4 = get_node ();
-	      L->node[L->k4].code = 11;
-	      L->node[L->k4].op1 = which - 1;
-	      L->node[L->k4].u.op2 = which - 1;
-	      L->node[L->k2].op1 = L->k4;
+	      L->k4 = get_node (L);
+	      CODE (L->k4) = 11;
+	      OP1 (L->k4) = which - 1;
+	      OP2 (L->k4) = which - 1;
+	      OP1 (L->k2) = L->k4;
 	    }
 	}
-      else if (L->node[L->n4].code == 4)
+      else if (CODE (L->n4) == 4)
 	{
-	  L->node[L->n1].code = 9;
+	  CODE (L->n1) = 9;
 
 	  switch (which)
 	    {
 
 	    case 5:
 	    case 6:
-	      L->node[L->n1].u.op2 = 0;
+	      OP2 (L->n1) = 0;
 	      break;
 	    case 7:
 	    case 8:
-	      L->node[L->n1].u.op2 = 1;
+	      OP2 (L->n1) = 1;
 	      break;
 	    }
 	  L->changed = TRUE;
 	}
-      else if (L->node[L->n4].code == 2)
+      else if (CODE (L->n4) == 2)
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
       else
 	{
 	  L->iterate = FALSE;
 	  L->error.wrong_operand_for_list_arithmetic += 1;
-	  err ("Wrong Operand for List Arithmetic\n");
+	  err (L, "Wrong Operand for List Arithmetic\n");
 	}
       break;
 
     case 15:			/* ---- iota */
 
-      if (L->node[L->n4].code == 9)
+      if (CODE (L->n4) == 9)
 	{
-	  if (L->node[L->n4].u.op2 > 0)
+	  if (OP2 (L->n4) > 0)
 	    {
-	      for (i = 1; i <= L->node[L->n4].u.op2; i++)
+	      for (i = 1; i <= OP2 (L->n4); i++)
 		{
-		  L->k1 = get_node ();
-		  L->node[L->k1].code = 9;
-		  L->node[L->k1].u.op2 = i;
-		  L->node[L->n1].code = 3;
-		  L->node[L->n1].op1 = L->k1;
-		  L->k2 = get_node ();
-		  L->node[L->k2].code = 4;
-		  L->node[L->n1].u.op2 = L->k2;
+		  L->k1 = get_node (L);
+		  CODE (L->k1) = 9;
+		  OP2 (L->k1) = i;
+		  CODE (L->n1) = 3;
+		  OP1 (L->n1) = L->k1;
+		  L->k2 = get_node (L);
+		  CODE (L->k2) = 4;
+		  OP2 (L->n1) = L->k2;
 		  L->n1 = L->k2;
 		}
 	      L->changed = TRUE;
 	    }
-	  else if (L->node[L->n4].u.op2 == 0)
+	  else if (OP2 (L->n4) == 0)
 	    {
-	      L->node[L->n1].code = 4;
+	      CODE (L->n1) = 4;
 	      L->changed = TRUE;
 	    }
 	  else
 	    {
 	      L->iterate = FALSE;
 	      L->error.wrong_operand_for_iota += 1;
-	      err ("Wrong Operand for iota\n");
+	      err (L, "Wrong Operand for iota\n");
 	    }
 	}
-      else if (L->node[L->n4].code == 2)
+      else if (CODE (L->n4) == 2)
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
       else
 	{
 	  L->iterate = FALSE;
 	  L->error.wrong_operand_for_iota += 1;
-	  err ("Wrong Operand for iota\n");
+	  err (L, "Wrong Operand for iota\n");
 	}
       break;
 
     case 16:			/* ---- show */
 
-      if (L->node[L->n4].code == 3)
+      if (CODE (L->n4) == 3)
 	{
-	  if (L->node[l_child (L->n4)].code > 4)
+	  if (CODE (l_child (L, L->n4)) > 4)
 	    {
 	      printf ("\n");
 	      printf ("Showing the list [");
-	      print_expression (l_child (L->n4));
-	      L->k1 = get_node ();
-	      L->node[L->k1].code = 11;
-	      L->node[L->k1].op1 = locate (" more      ");
-	      L->node[L->k1].u.op2 = 17;
-	      L->node[L->n1].op1 = L->k1;
-	      L->node[L->n1].u.op2 = r_child (L->n4);
+	      print_expression (L, l_child (L, L->n4));
+	      L->k1 = get_node (L);
+	      CODE (L->k1) = 11;
+	      OP1 (L->k1) = SYMBOL (L, "more");
+	      OP2 (L->k1) = 17;
+	      OP1 (L->n1) = L->k1;
+	      OP2 (L->n1) = r_child (L, L->n4);
 	    }
 	  else
 	    {
-	      store (L->n1);
-	      L->n1 = l_child (L->n4);
+	      store (L, L->n1);
+	      L->n1 = l_child (L, L->n4);
 	    }
 	}
-      else if (L->node[L->n4].code == 2)
+      else if (CODE (L->n4) == 2)
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
       else
 	{
 	  L->iterate = FALSE;
-	  err ("Wrong operand for Show\n");
+	  err (L, "Wrong operand for Show\n");
 	}
       break;
 
     case 17:			/* ---- more */
 
-      if (L->node[L->n4].code == 3)
+      if (CODE (L->n4) == 3)
 	{
-	  if (L->node[l_child (L->n4)].code > 4)
+	  if (CODE (l_child (L, L->n4)) > 4)
 	    {
 	      printf (",");
-	      print_expression (l_child (L->n4));
-	      L->node[L->n1].u.op2 = r_child (L->n4);
+	      print_expression (L, l_child (L, L->n4));
+	      OP2 (L->n1) = r_child (L, L->n4);
 	    }
 	  else
 	    {
-	      store (L->n1);
-	      L->n1 = l_child (L->n4);
+	      store (L, L->n1);
+	      L->n1 = l_child (L, L->n4);
 	    }
 	}
-      else if (L->node[L->n4].code == 2)
+      else if (CODE (L->n4) == 2)
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
-      else if (L->node[L->n4].code == 4)
+      else if (CODE (L->n4) == 4)
 	{
 	  printf ("]");
-	  L->node[L->n1].code = 4;
+	  CODE (L->n1) = 4;
 	}
       else
 	{
 	  L->iterate = FALSE;
-	  err ("Wrong operand for More\n");
+	  err (L, "Wrong operand for More\n");
 	}
       break;
 
     case 20:			/* ---- not */
 
-      if ((L->node[L->n4].code == 11) && (L->node[L->n4].op1 > 0))
+      if ((CODE (L->n4) == 11) && (OP1 (L->n4) > 0))
 	{
-	  if (L->node[L->n4].u.op2 == 21)
+	  if (OP2 (L->n4) == 21)
 	    {
-	      L->node[L->n1].code = 11;
-	      L->node[L->n1].op1 = locate (" FALSE     ");
-	      L->node[L->n1].u.op2 = 22;
+	      CODE (L->n1) = 11;
+	      OP1 (L->n1) = SYMBOL (L, "FALSE");
+	      OP2 (L->n1) = 22;
 	      L->changed = TRUE;
 	    }
-	  else if (L->node[L->n4].u.op2 == 22)
+	  else if (OP2 (L->n4) == 22)
 	    {
-	      L->node[L->n1].code = 11;
-	      L->node[L->n1].op1 = locate (" TRUE      ");
-	      L->node[L->n1].u.op2 = 21;
+	      CODE (L->n1) = 11;
+	      OP1 (L->n1) = SYMBOL (L, "TRUE");
+	      OP2 (L->n1) = 21;
 	      L->changed = TRUE;
 	    }
 	}
-      else if (L->node[L->n4].code == 2)
+      else if (CODE (L->n4) == 2)
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
       else
 	{
 	  L->iterate = FALSE;
 	  L->error.wrong_operand_for_not += 1;
-	  err ("Wrong Operand for not\n");
+	  err (L, "Wrong Operand for not\n");
 	}
       break;
 
     default:
 
-      err ("Function is not a built-in unary one\n");
+      err (L, "Function is not a built-in unary one\n");
     }
 }
 
 /*------------------------------------------------------------------*/
 
 PRIVATE void
-binary (int which)
+binary (interpreter * L, int which)
 {
   int code;
 
@@ -2719,108 +4686,108 @@ binary (int which)
 
     case 21:			/* ---- True */
 
-      L->node[L->n1].code = 0;
-      L->node[L->n1].op1 = 0;
-      L->node[L->n1].u.op2 = r_child (L->n2);
+      CODE (L->n1) = 0;
+      OP1 (L->n1) = 0;
+      OP2 (L->n1) = r_child (L, L->n2);
       L->changed = TRUE;
       break;
 
     case 22:			/* ---- False */
 
-      L->node[L->n1].code = 0;
-      L->node[L->n1].op1 = 0;
-      L->node[L->n1].u.op2 = L->n4;
+      CODE (L->n1) = 0;
+      OP1 (L->n1) = 0;
+      OP2 (L->n1) = L->n4;
       L->changed = TRUE;
       break;
 
     case 23:
     case 24:			/* ---- and/or */
 
-      L->n5 = r_child (L->n2);
-      if ((L->node[L->n4].code == 11) && (L->node[L->n4].op1 > 0) &&
-	  ((L->node[L->n4].u.op2 == 21) || (L->node[L->n4].u.op2 == 22)))
+      L->n5 = r_child (L, L->n2);
+      if ((CODE (L->n4) == 11) && (OP1 (L->n4) > 0) &&
+	  ((OP2 (L->n4) == 21) || (OP2 (L->n4) == 22)))
 	{
-	  if ((L->node[L->n5].code == 11) && (L->node[L->n5].op1 > 0) &&
-	      ((L->node[L->n5].u.op2 == 21) || (L->node[L->n5].u.op2 == 22)))
+	  if ((CODE (L->n5) == 11) && (OP1 (L->n5) > 0) &&
+	      ((OP2 (L->n5) == 21) || (OP2 (L->n5) == 22)))
 	    {
 
-	      L->node[L->n1].code = 11;		/* leaf node */
+	      CODE (L->n1) = 11;		/* leaf node */
 	      L->changed = TRUE;
 
-	      if (((L->node[L->n4].u.op2 == 21) && (L->node[L->n5].u.op2 == 21)
+	      if (((OP2 (L->n4) == 21) && (OP2 (L->n5) == 21)
 		   && (which == 23))
-		  || (((L->node[L->n4].u.op2 == 21) || (L->node[L->n5].u.op2 == 21))
+		  || (((OP2 (L->n4) == 21) || (OP2 (L->n5) == 21))
 		      && (which == 24)))
 		{
 
-		  L->node[L->n1].op1 = locate (" TRUE      ");
-		  L->node[L->n1].u.op2 = 21;
+		  OP1 (L->n1) = SYMBOL (L, "TRUE");
+		  OP2 (L->n1) = 21;
 		}
 	      else
 		{
-		  L->node[L->n1].op1 = locate (" FALSE     ");
-		  L->node[L->n1].u.op2 = 22;
+		  OP1 (L->n1) = SYMBOL (L, "FALSE");
+		  OP2 (L->n1) = 22;
 		}
 	    }
-	  else if (L->node[L->n5].code == 2)
+	  else if (CODE (L->n5) == 2)
 	    {
-	      store (L->n1);
+	      store (L, L->n1);
 	      L->n1 = L->n5;
 	    }
 	  else
 	    {
 	      L->iterate = FALSE;
 	      L->error.wrong_first_operand_for_and_or += 1;
-	      err ("Wrong First Operand for and/or\n");
+	      err (L, "Wrong First Operand for and/or\n");
 	    }
 	}
-      else if (L->node[L->n4].code == 2)
+      else if (CODE (L->n4) == 2)
 	{
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	}
       else
 	{
 	  L->iterate = FALSE;
 	  L->error.wrong_second_operand_for_and_or += 1;
-	  err ("Wrong Second Operand for and/or\n");
+	  err (L, "Wrong Second Operand for and/or\n");
 	}
       break;
 
     case 25:			/* ---- map */
 
-      switch (L->node[L->n4].code)
+      switch (CODE (L->n4))
 	{
 
 	case 1:
 	case 2:
 
-	  store (L->n1);
+	  store (L, L->n1);
 	  L->n1 = L->n4;
 	  break;
 
 	case 3:
 
-	  L->k1 = get_node ();
-	  L->node[L->k1].code = 2;
-	  L->node[L->k1].op1 = L->n2;	/* temporary */
-	  L->node[L->k1].u.op2 = l_child (L->n4);
-	  L->node[L->n1].code = 3;
-	  L->node[L->n1].op1 = L->k1;
-	  L->k2 = get_node ();
-	  L->node[L->k2].code = 2;
-	  L->node[L->k2].op1 = L->n2;
-	  L->node[L->k2].u.op2 = r_child (L->n4);
-	  L->node[L->k1].op1 = r_child (L->n2);
-	  L->node[L->n1].u.op2 = L->k2;
-	  go_back ();
+	  L->k1 = get_node (L);
+	  CODE (L->k1) = 2;
+	  OP1 (L->k1) = L->n2;	/* temporary */
+	  OP2 (L->k1) = l_child (L, L->n4);
+	  CODE (L->n1) = 3;
+	  OP1 (L->n1) = L->k1;
+	  L->k2 = get_node (L);
+	  CODE (L->k2) = 2;
+	  OP1 (L->k2) = L->n2;
+	  OP2 (L->k2) = r_child (L, L->n4);
+	  OP1 (L->k1) = r_child (L, L->n2);
+	  OP2 (L->n1) = L->k2;
+	  go_back (L);
 	  L->changed = TRUE;
 	  break;
 
 	case 4:
 
-	  L->node[L->n1].code = 4;
-	  go_back ();
+	  CODE (L->n1) = 4;
+	  go_back (L);
 	  L->changed = TRUE;
 	  break;
 
@@ -2828,14 +4795,14 @@ binary (int which)
 
 	  L->iterate = FALSE;
 	  L->error.wrong_argument_for_map += 1;
-	  err ("Wrong Argument for Map\n");
+	  err (L, "Wrong Argument for Map\n");
 	  break;
 	}
       break;
 
     case 26:			/* ---- append */
 
-      code = L->node[r_child (L->n2)].code;
+      code = CODE (r_child (L, L->n2));
 
       switch (code)
 	{
@@ -2843,31 +4810,31 @@ binary (int which)
 	case 1:
 	case 2:
 
-	  store (L->n1);
-	  L->n1 = r_child (L->n2);
+	  store (L, L->n1);
+	  L->n1 = r_child (L, L->n2);
 	  break;
 
 	case 3:
 
-	  L->node[L->n1].code = 3;
-	  L->k1 = get_node ();
-	  L->node[L->k1].code = 2;
-	  L->node[L->k1].u.op2 = L->n4;
-	  L->node[L->n1].u.op2 = L->k1;
-	  L->k2 = get_node ();
-	  L->node[L->k2].code = 2;
-	  L->node[L->k2].op1 = l_child (L->n2);
-	  L->node[L->k2].u.op2 = r_child (r_child (L->n2));
-	  L->node[L->k1].op1 = L->k2;
-	  L->node[L->n1].op1 = l_child (r_child (L->n2));
-	  go_back ();
+	  CODE (L->n1) = 3;
+	  L->k1 = get_node (L);
+	  CODE (L->k1) = 2;
+	  OP2 (L->k1) = L->n4;
+	  OP2 (L->n1) = L->k1;
+	  L->k2 = get_node (L);
+	  CODE (L->k2) = 2;
+	  OP1 (L->k2) = l_child (L, L->n2);
+	  OP2 (L->k2) = r_child (L, r_child (L, L->n2));
+	  OP1 (L->k1) = L->k2;
+	  OP1 (L->n1) = l_child (L, r_child (L, L->n2));
+	  go_back (L);
 	  L->changed = TRUE;
 	  break;
 
 	case 4:
 
-	  L->node[L->n1].code = 0;
-	  go_back ();
+	  CODE (L->n1) = 0;
+	  go_back (L);
 	  L->changed = TRUE;
 	  break;
 
@@ -2875,14 +4842,14 @@ binary (int which)
 
 	  L->iterate = FALSE;
 	  L->error.wrong_operand_for_append += 1;
-	  err ("Wrong Operand for Append\n");
+	  err (L, "Wrong Operand for Append\n");
 	  break;
 	}
       break;
 
     default:
 
-      err ("Function is not built-in binary\n");
+      err (L, "Function is not built-in binary\n");
       break;
     }
 }
@@ -2914,9 +4881,9 @@ binary (int which)
 /*==================================================================*/
 
 PRIVATE int
-alpha_standardize (int rt)
+alpha_standardize (interpreter * L, int rt)
 {
-  static int track[SIZE + 1];
+  int *track;
   int point;
   int top;
   int next;
@@ -2927,73 +4894,42 @@ alpha_standardize (int rt)
   top = 0;
   more = TRUE;
   scope_id = 0;
-
-  if (setjmp (LONGJUMP))
-    return 0;
+  track = L->track.item;
+  need_scope (L);
 
   while (more)
     {
-      switch (L->heap[point].code)
+      switch (CODE (point))
 	{
 
 	case 0:		/* ---- indirection ---- */
 
-	  point = L->heap[point].u.op2;
+	  point = OP2 (point);
 	  break;
 
 	case 1:		/* ---- abstraction ---- */
 
-	  L->heap[point].scope = ++scope_id;
-	  next = L->heap[point].op1;
-	  point = L->heap[point].u.op2;
-	  scope (next, point, scope_id);
+	  SCOPE (point) = ++scope_id;
+	  next = OP1 (point);
+	  point = OP2 (point);
+	  scope (L, next, point, scope_id);
 	  break;
 
 	case 2:		/* ---- application ---- */
 
-	  if (top < SIZE)
-	    track[++top] = L->heap[point].u.op2;
-	  else
-	    {
-	      more = FALSE;
-	      err ("alpha_standardize track overflow.\n");
-	    }
-	  point = L->heap[point].op1;
-	  break;
-
-	case 3:
-	case 13:		/* ---- list structure ---- */
-
-	  if (L->heap[point].code == 3);
-	  else
-	    L->heap[point].code = 3;
-
-	  if (top < L->parms->stack_size)
-	    {
-	      top++;
-	      next = r_child (point);	/* needed here */
-	      track[top] = next;
-	      if ((L->heap[next].code == 3) || (L->heap[next].code == 4))
-		L->heap[next].code = L->heap[next].code + 10;
-	    }
-	  else
-	    {
-	      more = FALSE;
-	      err ("alpha_standardize track overflow.\n");
-	    }
-	  point = L->heap[point].op1;
+	  track = stack_room (&L->track, top);
+	  track[++top] = OP2 (point);
+	  point = OP1 (point);
 	  break;
 
-	case 4:
-	case 14:		/* ---- empty list or end of list ---- */
-
-	  if (L->heap[point].code == 4);
-	  else
-	    L->heap[point].code = 4;
+	case 3:		/* ---- list structure ---- */
 
-	  point = silent_pop (track, &top, &more);
+	  track = stack_room (&L->track, top);
+	  track[++top] = OP2 (point);
+	  point = OP1 (point);
 	  break;
 
+	case 4:		/* ---- empty list or end of list ---- */
 	case 5:
 	case 6:
 	case 7:
@@ -3009,14 +4945,14 @@ alpha_standardize (int rt)
 
 	default:		/* ---- renaming prefix ---- */
 
-	  if (L->heap[point].code < 0)
+	  if (CODE (point) < 0)
 	    {
-	      point = r_child (point);
+	      point = r_child (L, point);
 	    }
 	  else
 	    {
-	      err ("\n");
-	      err ("Wrong Expression!\n");
+	      err (L, "\n");
+	      err (L, "Wrong Expression!\n");
 	      more = FALSE;
 	    }
 	  break;
@@ -3057,59 +4993,54 @@ silent_pop (int *track, int *top, boolean * more)
  */
 
 PRIVATE void
-scope (int id, int point, int scope_id)
+scope (interpreter * L, int id, int point, int scope_id)
 {
-  static int trace[SIZE + 1];
+  int *trace;
   boolean move;
-  int top, self;
+  int top;
 
   move = TRUE;
   top = 0;
-  self = point;
+  trace = L->trace.item;
+  new_epoch (L);
 
   while (move)
     {
-      if (L->heap[point].marker)
+      if (VISITED (point))
 	point = back_up (&top, &move, trace);
       else
 	{
-	  L->heap[point].marker = TRUE;
+	  VISIT (point);
 
-	  switch (L->heap[point].code)
+	  switch (CODE (point))
 	    {
 
 	    case 0:		/* ---- indirection ---- */
 
-	      point = r_child (point);
+	      point = r_child (L, point);
 	      break;
 
 	    case 1:		/* ---- abstraction ---- */
 
-	      if (id == L->heap[point].op1)
+	      if (id == OP1 (point))
 		point = back_up (&top, &move, trace);
 	      else
-		point = r_child (point);
+		point = r_child (L, point);
 	      break;
 
 	    case 2:
 	    case 3:		/* ---- application or list ---- */
 
-	      if (top < SIZE)
-		trace[++top] = r_child (point);
-	      else
-		{
-		  move = FALSE;
-		  err ("scope(): trace overflow.\n");
-		  longjmp (LONGJUMP, 1);
-		}
-	      point = l_child (point);
+	      trace = stack_room (&L->trace, top);
+	      trace[++top] = r_child (L, point);
+	      point = l_child (L, point);
 	      break;
 
 	    case 11:		/* ---- variable ---- */
 
-	      if (id == L->heap[point].op1)
+	      if (id == OP1 (point))
 		{
-		  L->heap[point].scope = scope_id;
+		  SCOPE (point) = scope_id;
 		}
 	      else
 		point = back_up (&top, &move, trace);
@@ -3123,113 +5054,449 @@ scope (int id, int point, int scope_id)
 	    }			/* switch */
 	}			/* else */
     }				/* while */
+}
 
-  top = 0;			/* restore the marker */
-  point = self;
-  move = TRUE;
+/*------------------------------------------------------------------*/
 
-  while (move)
+/*
+ * alpha_standardize() in a single walk (parms->de_bruijn): the binders
+ * in scope sit on a stack, so a variable finds its binder as a de
+ * Bruijn index would, by looking down the stack, instead of scope()
+ * walking the body of every abstraction.  Sets the same SCOPE values,
+ * and does not touch the list codes.
+ */
+
+PRIVATE int
+resolve_binders (interpreter * L, int rt)
+{
+  int *track;			/* pending right operands; ~depth restores */
+  int *binder;			/* abstractions in scope */
+  int point;
+  int top;
+  int depth;
+  int scope_id;
+  int i;
+
+  track = L->track.item;
+  binder = L->trace.item;
+  point = rt;
+  top = 0;
+  depth = 0;
+  scope_id = 0;
+  need_scope (L);
+
+  for (;;)
     {
-      if (!L->heap[point].marker)
-	point = back_up (&top, &move, trace);
-      else
+      while (CODE (point) == 0)
+	point = OP2 (point);
+
+      if (CODE (point) == 1)
+	{			/* ---- abstraction ---- */
+	  SCOPE (point) = ++scope_id;
+	  track = stack_room (&L->track, top);
+	  track[++top] = ~depth;
+	  binder = stack_room (&L->trace, depth);
+	  binder[++depth] = point;
+	  point = OP2 (point);
+	  continue;
+	}
+      if (CODE (point) == 2 || CODE (point) == 3)
+	{			/* ---- application or list ---- */
+	  track = stack_room (&L->track, top);
+	  track[++top] = OP2 (point);
+	  point = OP1 (point);
+	  continue;
+	}
+      if (CODE (point) < 0)
+	{			/* ---- renaming prefix ---- */
+	  point = OP2 (point);
+	  continue;
+	}
+      if (CODE (point) == 11)
+	{			/* ---- variable ---- */
+	  for (i = depth; i > 0; i--)
+	    if (OP1 (binder[i]) == OP1 (point))
+	      {
+		SCOPE (point) = SCOPE (binder[i]);
+		break;
+	      }
+	}
+      else if (CODE (point) == 12 || CODE (point) > 16)
 	{
-	  L->heap[point].marker = FALSE;
+	  err (L, "\n");
+	  err (L, "Wrong Expression!\n");
+	  return 0;
+	}
 
-	  switch (L->heap[point].code)
-	    {
+      do
+	{			/* next pending operand */
+	  if (top == 0)
+	    return !L->error_number;
+	  point = track[top--];
+	  if (point < 0)
+	    depth = ~point;
+	}
+      while (point < 0);
+    }
+}
 
-	    case 0:		/* ---- indirection ---- */
+/*------------------------------------------------------------------*/
 
-	      point = r_child (point);
-	      break;
+PRIVATE int
+free_vars_list (interpreter * L, boolean first)
+{
+  int n_free;
+  int listed;
+  int i;
+
+  listed = collect_free (L, L->root, first);
+
+  n_free = 0;
+  for (i = 1; i <= L->n_identifiers; i++)	/* in order of appearance */
+    if (L->symbol_mark[L->identifiers[i]] & SYM_FREE)
+      L->free_vars[++n_free] = L->identifiers[i];
+  for (i = 1; i <= listed; i++)
+    L->symbol_mark[L->names.item[i]] &= ~SYM_FREE;
+
+  L->n_free_vars = n_free;
+
+  /* print_free_vars_list(stdout); */
+
+  return 1;
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * the free variables of the parsed term at rt, in one walk instead of
+ * a not_free() walk per identifier: while the body of an abstraction
+ * is walked, the mark of its id carries one more SYM_BOUND, so an
+ * occurrence is free if its mark has none.  The first free occurrence
+ * of an id sets SYM_FREE and lists the id on the names stack; returns
+ * how many are listed.  The walk skips what lies below a point where
+ * no identifier (SYM_LISTED) could still occur free, and with first
+ * ends at the first that does.
+ */
+
+PRIVATE int
+collect_free (interpreter * L, int rt, boolean first)
+{
+  int *track;			/* pending right operands; ~id leaves a body */
+  int *names;
+  int *mark;
+  int point;
+  int top;
+  int open;			/* identifiers neither bound nor seen free */
+  int n;
+  int id;
+  boolean more;
+
+  track = L->track.item;
+  names = L->names.item;
+  mark = L->symbol_mark;
+  point = rt;
+  top = 0;
+  open = L->n_identifiers;
+  n = 0;
+  more = TRUE;
+
+  while (more)
+    {
+      while (CODE (point) == 0)
+	point = OP2 (point);
+
+      if (open > 0)		/* else nothing below is of interest */
+	switch (CODE (point))
+	  {
+
+	  case 1:		/* ---- abstraction ---- */
+
+	    id = OP1 (point);
+	    if (mark[id] == SYM_LISTED)
+	      open--;
+	    mark[id] += SYM_BOUND;
+	    track = stack_room (&L->track, top);
+	    track[++top] = ~id;
+	    point = OP2 (point);
+	    continue;
+
+	  case 2:
+	  case 3:		/* ---- application or list ---- */
+
+	    track = stack_room (&L->track, top);
+	    track[++top] = OP2 (point);
+	    point = OP1 (point);
+	    continue;
+
+	  case 11:		/* ---- variable ---- */
+
+	    id = OP1 (point);
+	    if (mark[id] < SYM_BOUND && !(mark[id] & SYM_FREE))
+	      {
+		if (mark[id] & SYM_LISTED)
+		  {
+		    open--;
+		    more = !first;
+		  }
+		mark[id] |= SYM_FREE;
+		names = stack_room (&L->names, n);
+		names[++n] = id;
+	      }
+	    break;
+	  }
+
+      while (more)
+	{			/* next pending operand */
+	  if (top == 0)
+	    more = FALSE;
+	  else if ((point = track[top--]) >= 0)
+	    break;
+	  else if ((mark[~point] -= SYM_BOUND) == SYM_LISTED)
+	    open++;
+	}
+    }
+
+  while (top > 0)		/* leave the bodies */
+    if ((point = track[top--]) < 0)
+      mark[~point] -= SYM_BOUND;
+
+  return n;
+}
+
+/*------------------------------------------------------------------*/
+
+PRIVATE void
+print_free_vars_list (interpreter * L, FILE * fp)
+{
+  int i;
+
+  fprintf (fp, "\n");
+  fprintf (fp, "free variables:\n");
+  fprintf (fp, "\n");
+
+  for (i = 1; i <= L->n_free_vars; i++)
+    fprintf (fp, "%d: %s\n", i, L->table[L->free_vars[i]].symbol);
+  fprintf (fp, "\n");
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * prints the normal form at rt as standardize() and bind_all_free_vars()
+ * would leave its text, but straight from the graph: the free variables
+ * are bound around the term, the last one to occur outermost, and the
+ * abstractions are numbered in the order they print (FUSED).  A first
+ * read-only walk collects the free variables on the names stack and
+ * checks that the text would read back as printed; if it would not
+ * (renaming prefixes, negative or unstable numbers, names the parser
+ * would cut short or take for others) nothing is printed and FALSE is
+ * returned, so that the text takes the long way.
+ */
+
+PRIVATE boolean
+standard_form (interpreter * L, int rt)
+{
+  int *track;			/* pending right operands; ~depth restores */
+  int *binder;			/* ids of the enclosing abstractions */
+  int *names;			/* free variables, in order of occurrence */
+  int point;
+  int top;
+  int depth;
+  int n_free;
+  int n_binders;
+  int digits;
+  int id;
+  int i;
+  size_t length;		/* of the text, but for the names */
+  size_t names_in_text;
+  boolean more;
+  char num[64];
+  char again[64];
+
+  track = L->track.item;
+  binder = L->trace.item;
+  point = rt;
+  top = 0;
+  depth = 0;
+  n_free = 0;
+  n_binders = 0;
+  length = 0;
+  names_in_text = 0;
+  more = TRUE;
+
+  while (more)
+    {
+      while (CODE (point) == 0)
+	point = OP2 (point);
+      if (L->parms->max_output > 0 && length > (size_t) L->parms->max_output)
+	return FALSE;		/* the text overflows anyway */
+      length += 2;		/* the most any node prints, but for names */
+
+      switch (CODE (point))
+	{
+
+	case 1:		/* ---- abstraction ---- */
+
+	  id = OP1 (point);
+	  if (!reads_back (L, id) || (id > 0 && L->table[id].key != 0))
+	    return FALSE;
+	  length += id_length (L, id);
+	  names_in_text++;
+	  n_binders++;
+	  track = stack_room (&L->track, top);
+	  track[++top] = ~depth;
+	  binder = stack_room (&L->trace, depth);
+	  binder[++depth] = id;
+	  point = OP2 (point);
+	  continue;
+
+	case 3:		/* ---- list structure ---- */
+
+	  for (i = OP2 (point); CODE (i) == 0; i = OP2 (i));
+	  if (CODE (i) != 3 && CODE (i) != 4)
+	    return FALSE;	/* a cons in part, prints as [a)b */
+	  /* fall through */
+
+	case 2:		/* ---- application ---- */
+
+	  track = stack_room (&L->track, top);
+	  track[++top] = OP2 (point);
+	  point = OP1 (point);
+	  continue;
+
+	case 4:
+	case 5:
+	case 6:
+	case 7:
+	case 8:
+	case 15:
+	case 16:
+
+	  break;
+
+	case 9:		/* ---- integer ---- */
+
+	  if (OP2 (point) < 0)
+	    return FALSE;
+	  length += 10;
+	  break;
 
-	    case 1:		/* ---- abstraction ---- */
+	case 10:		/* ---- real ---- */
 
-	      if (id == L->heap[point].op1)
-		point = back_up (&top, &move, trace);
-	      else
-		point = r_child (point);
-	      break;
+	  snprintf (num, sizeof (num), "%5.5f", ALT (point));
+	  for (i = 0; isdigit ((unsigned char) num[i]); i++);
+	  if (i == 0 || i > 9 || num[i] != '.')
+	    return FALSE;
+	  snprintf (again, sizeof (again), "%5.5f",
+		    fraction (atoi (num), num + i + 1, strlen (num + i + 1)));
+	  if (strcmp (num, again) != 0)
+	    return FALSE;
+	  length += strlen (num);
+	  break;
 
-	    case 2:
-	    case 3:		/* ---- application or list ---- */
+	case 11:		/* ---- variable or key word ---- */
 
-	      trace[++top] = r_child (point);
-	      point = l_child (point);
+	  id = OP1 (point);
+	  if (!reads_back (L, id))
+	    return FALSE;
+	  length += id_length (L, id);
+	  names_in_text++;
+	  for (i = depth; i > 0; i--)
+	    if (binder[i] == id)
 	      break;
+	  if (i > 0 || (id > 0 && L->table[id].key != 0))
+	    break;
+	  names = L->names.item;
+	  for (i = 1; i <= n_free; i++)
+	    if (names[i] == id)
+	      break;
+	  if (i > n_free)
+	    {
+	      if (made_name (L, id))
+		return FALSE;	/* make_name() would step around it */
+	      names = stack_room (&L->names, n_free);
+	      names[++n_free] = id;
+	    }
+	  break;
 
-	    default:
+	default:		/* ---- renaming prefix, or wrong ---- */
 
-	      point = back_up (&top, &move, trace);
+	  return FALSE;
+	}
+
+      do
+	{			/* next pending operand */
+	  if (top == 0)
+	    {
+	      more = FALSE;
 	      break;
+	    }
+	  point = track[top--];
+	  if (point < 0)
+	    depth = ~point;
+	}
+      while (point < 0);
+    }
 
-	    }			/* switch */
-	}			/* else */
-    }				/* while */
+  for (i = n_binders + n_free, digits = 1; i >= 10; i /= 10)
+    digits++;
+  if (n_free > 0 && (digits + 1 > L->parms->name_length
+		     || L->char_class[(unsigned char) L->parms->standard_variable] != CC_LETTER))
+    return FALSE;		/* the names are read back once more */
+  length += (names_in_text + n_free) * (digits + 1) + 2 * n_free;
+  if (L->parms->max_output > 0 && length > (size_t) L->parms->max_output)
+    return FALSE;		/* some text on the way might overflow */
+
+  L->standard = FUSED;
+  L->scope_offset = n_free;
+  L->binders = 0;
+  L->binder_count = 0;
+  print_expression (L, rt);
+  return TRUE;
 }
 
 /*------------------------------------------------------------------*/
 
+/* the length of the name print_id() gives id */
+
 PRIVATE int
-free_vars_list ()
+id_length (interpreter * L, int id)
 {
-  int n_free;
-  int i;
-  int j;
-  boolean dejavu;
-  char symbol[SMALL];
+  int digits;
 
-  if (setjmp (LONGJUMP))
-    {
-      L->n_free_vars = n_free;
-      return 0;
-    }
-
-  n_free = 0;
-
-  for (i = 1; i <= L->n_identifiers; i++)
-    {
-      if (not_free (L->identifiers[i], L->root) == 0)
-	{
-	  strip (L->table[L->identifiers[i]].symbol, symbol);
-	  L->free_vars[++n_free] = (char *) space (sizeof (char) * (strlen (symbol) + 1));
-	  strcpy (L->free_vars[n_free], symbol);
-	}
-    }
-
-  L->n_free_vars = n_free;
-
-  /* print_free_vars_list(stdout); */
-
-  return 1;
+  if (id > 0)
+    return L->table[id].length;
+  for (digits = 1; id <= -10; id /= 10)
+    digits++;
+  return digits + 1;
 }
 
 /*------------------------------------------------------------------*/
 
-PRIVATE void
-clear_free_vars_list (int n)
+/* whether the name of id looks like one make_name() makes */
+
+PRIVATE boolean
+made_name (interpreter * L, int id)
 {
-  int i;
+  element *symbol;
 
-  for (i = 1; i <= n; i++)
-    free (L->free_vars[i]);
+  if (id <= 0)
+    return L->parms->standard_variable == '$';
+  symbol = &L->table[id];
+  return symbol->symbol[0] == L->parms->standard_variable && symbol->length > 1
+    && strspn (symbol->symbol + 1, "0123456789") == (size_t) symbol->length - 1;
 }
 
 /*------------------------------------------------------------------*/
 
-PRIVATE void
-print_free_vars_list (FILE * fp)
-{
-  int i;
-
-  fprintf (fp, "\n");
-  fprintf (fp, "free variables:\n");
-  fprintf (fp, "\n");
+/* whether the name of id reads back as that identifier and no other */
 
-  for (i = 1; i <= L->n_free_vars; i++)
-    fprintf (fp, "%d: %s\n", i, L->free_vars[i]);
-  fprintf (fp, "\n");
+PRIVATE boolean
+reads_back (interpreter * L, int id)
+{
+  if (id > 0)
+    return L->table[id].symbol[0] != '$';	/* might be a $n */
+  return id_length (L, id) <= L->parms->name_length;
 }
 
 /*------------------------------------------------------------------*/
@@ -3237,48 +5504,47 @@ print_free_vars_list (FILE * fp)
 PUBLIC char *
 standardize (char *expression, interpreter * Interp)
 {
+  interpreter *L;
   char *result;
-  char buffer[BUFSIZE];
-  int i;
   int body;
 
-  if (!expression || strlen (expression) >= (BUFSIZE-10))
+  if (!expression)
       return NULL;
 
   L = Interp;
   L->output_expression[0] = '\0';
+  L->output_length = 0;
 
-  if (setjmp (RECOVER))
+  if (setjmp (L->recover))
     return NULL;
   
-  strcpy (buffer, expression);
-  strcat (buffer, ";");
+  L->input_expression = expression;
 
-  L->input_expression = buffer;
+  clear (L);
+  L->input_end = strlen (expression);
+  L->terminate = TRUE;		/* in place of a copy with ; appended */
 
-  clear ();
-
-  L->peek = str_getc (L->input_expression);
-  body = get_node ();
+  L->peek = str_getc (L, L->input_expression);
+  body = get_node (L);
   L->root = body;
 
   if (L->peek == '\0')
     return NULL;
 
-  parse (&body);
+  parse (L, &body);
 
   /* list of free variables */
 
-  if (free_vars_list () && alpha_standardize (L->root))
+  if (free_vars_list (L, FALSE) && (L->parms->de_bruijn ? resolve_binders (L, L->root)
+			     : alpha_standardize (L, L->root)))
     {
+      taken_suffixes (L);
       L->standard = TRUE;
-      print_expression (L->root);
+      print_expression (L, L->root);
     }
 
-  clear_free_vars_list (L->n_free_vars);
-
-  result = (char *) space (sizeof (char) * (strlen (L->output_expression) + 1));
-  strcpy (result, L->output_expression);
+  result = (char *) space (sizeof (char) * (L->output_length + 1));
+  memcpy (result, L->output_expression, L->output_length + 1);
 
   return result;
 }
@@ -3297,8 +5563,8 @@ standardize (char *expression, interpreter * Interp)
 PUBLIC char *
 bind_all_free_vars (char *expression, interpreter * Interp)
 {
+  interpreter *L;
   char *bound;
-  char *expr;
   char *result;
   int body;
   int i;
@@ -3307,58 +5573,52 @@ bind_all_free_vars (char *expression, interpreter * Interp)
   L = Interp;
 
   L->output_expression[0] = '\0';
+  L->output_length = 0;
 
   if (!expression){
     return NULL;
   }
-  expr = (char *) space (sizeof (char) * ((len = strlen (expression)) + 2));
-  strcpy (expr, expression);
-  strcat (expr, ";");
+  len = strlen (expression);
 
-  if (setjmp (RECOVER))
-    {
-      free (expr);
-      return NULL;
-    }
+  if (setjmp (L->recover))
+    return NULL;
     
-  L->input_expression = expr;
+  L->input_expression = expression;
 
-  clear ();
+  clear (L);
+  L->input_end = len;
+  L->terminate = TRUE;
 
-  L->peek = str_getc (L->input_expression);
-  body = get_node ();
+  L->peek = str_getc (L, L->input_expression);
+  body = get_node (L);
   L->root = body;
 
   if (L->peek == '\0')
     return NULL;
 
-  parse (&body);
-
-  free (expr);
+  parse (L, &body);
 
   /* list of free variables */
 
-  if (!free_vars_list () || !L->n_free_vars)
+  if (!free_vars_list (L, FALSE) || !L->n_free_vars)
     {				
-      clear_free_vars_list (L->n_free_vars);
       bound = (char *) space (sizeof (char));
       *bound = '\0';
       return bound;
     }
 
-  bound = (char *) space (sizeof (char) * (len + L->n_free_vars * 12));
+  bound = (char *) space (sizeof (char) * (len + L->n_free_vars * (L->parms->name_length + 2) + 1));
 
   strcpy (bound, "\\");
-  strcat (bound, L->free_vars[L->n_free_vars]);
+  strcat (bound, L->table[L->free_vars[L->n_free_vars]].symbol);
   strcat (bound, ".");
   for (i = L->n_free_vars - 1; i >= 1; i--)
     {				/* bind them */
       strcat (bound, "\\");
-      strcat (bound, L->free_vars[i]);
+      strcat (bound, L->table[L->free_vars[i]].symbol);
       strcat (bound, ".");
     }
   strcat (bound, expression);
-  clear_free_vars_list (L->n_free_vars);	/* drop free vars list */
 
   return bound;
 }
@@ -3368,102 +5628,142 @@ bind_all_free_vars (char *expression, interpreter * Interp)
 PUBLIC int
 Free_Variables (char *expression, interpreter * Interp)
 {
-  char *bound;
-  char *expr;
+  interpreter *L;
   int result;
   int body;
-  int i;
-  int len;
 
   L = Interp;
 
   L->output_expression[0] = '\0';
+  L->output_length = 0;
 
   if (!expression)
     return 0;
 
-  expr = (char *) space (sizeof (char) * ((len = strlen (expression)) + 2));
-  strcpy (expr, expression);
-  strcat (expr, ";");
-
-  if (setjmp (RECOVER))
-    {
-      free (expr);
-      return 0;
-    }
+  if (setjmp (L->recover))
+    return 0;
     
-  L->input_expression = expr;
+  L->input_expression = expression;
 
-  clear ();
+  clear (L);
+  L->input_end = strlen (expression);
+  L->terminate = TRUE;
 
-  L->peek = str_getc (L->input_expression);
-  body = get_node ();
+  L->peek = str_getc (L, L->input_expression);
+  body = get_node (L);
   L->root = body;
 
   if (L->peek == '\0')
     return 0;
 
-  parse (&body);
-
-  free (expr);
+  parse (L, &body);
 
   /* list of free variables */
 
-  if (!free_vars_list () || !L->n_free_vars) {
+  if (!free_vars_list (L, TRUE) || !L->n_free_vars) {
     result = 0;
   } else {
     result = 1;
   }
 
   L->output_expression[0] = '\0';
-
-  clear_free_vars_list (L->n_free_vars);	/* drop free vars list */
+  L->output_length = 0;
 
   return result;
 }
 
 /*==================================================================*/
 
-/* get next character from input string */
+/*
+ * consumes the run of characters of the given classes that follows
+ * L->peek in the input and returns its length.
+ * A run ends where str_getc() would stop or translate: at the end of
+ * a view, at a NUL, and at any blank.  With SSE2 16 characters are
+ * classified at a time, for the fixed letters and numbers set up by
+ * initialize_lambda(); a load never reaches past input_end.
+ */
 
-PRIVATE int
-str_getc (char *string)
+PRIVATE size_t
+scan_run (interpreter * L, int class)
 {
-  int c;
-
-  switch (c = string[L->char_count++])
+  const unsigned char *s;
+  size_t room;
+  size_t i;
+#ifdef __SSE2__
+  size_t known;
+  __m128i x, y, in;
+  int miss;
+#endif
+
+  s = (const unsigned char *) L->input_expression + L->char_count;
+  room = (L->input_length == LAMBDA_NUL) ? (size_t) -1 : L->input_length - L->char_count;
+  i = 0;
+
+#ifdef __SSE2__
+  known = (L->input_end > (size_t) L->char_count) ? L->input_end - L->char_count : 0;
+  while (known - i >= 16)
     {
-
-    case '\0':
-    case '\n':
-      L->char_count = 0;
-      return ((int) '\0');
-      break;
-    default:
-      return c;
-      break;
+      x = _mm_loadu_si128 ((const __m128i *) (s + i));
+      y = _mm_sub_epi8 (x, _mm_set1_epi8 ('0'));
+      in = _mm_cmpeq_epi8 (_mm_min_epu8 (y, _mm_set1_epi8 (9)), y);
+      if (class & CC_LETTER)
+	{			/* a-z, A-Z and $ */
+	  y = _mm_sub_epi8 (_mm_or_si128 (x, _mm_set1_epi8 (0x20)), _mm_set1_epi8 ('a'));
+	  in = _mm_or_si128 (in, _mm_cmpeq_epi8 (_mm_min_epu8 (y, _mm_set1_epi8 (25)), y));
+	  in = _mm_or_si128 (in, _mm_cmpeq_epi8 (x, _mm_set1_epi8 ('$')));
+	}
+      miss = ~_mm_movemask_epi8 (in) & 0xffff;
+      if (miss)
+	{
+	  i += __builtin_ctz (miss);
+	  L->char_count += i;
+	  return i;
+	}
+      i += 16;
     }
+#endif
+
+  while (i < room && (L->char_class[s[i]] & class))
+    i++;
+  L->char_count += i;
+  return i;
 }
 
 /*==================================================================*/
 
-PRIVATE void
-strip (char *string, char *string2)
+/* get next character from input string */
+
+PRIVATE int
+str_getc (interpreter * L, char *string)
 {
-  int i, j, k;
+  int c;
 
-  for (i = 0; i < strlen (string) && string[i] == ' '; i++);
-  for (j = strlen (string) - 1; j >= 0 && string[j] == ' '; j--);
+  if ((size_t) L->char_count >= L->input_length)
+    c = '\0';			/* end of a view */
+  else if ((c = string[L->char_count]) == '\n' && L->input_length == LAMBDA_NUL)
+    c = '\0';
 
-  for (k = i; k <= j; k++)
-    string2[k - i] = string[k];
-  string2[j - i + 1] = '\0';
+  if (c == '\0')
+    {
+      if (L->terminate)
+	{			/* the end reads as ; once */
+	  L->terminate = FALSE;
+	  return ((int) ';');
+	}
+      L->char_count = 0;
+      return ((int) '\0');
+    }
+
+  L->char_count++;
+  if ((c == '\n' || c == '\r' || c == '\t') && L->input_length != LAMBDA_NUL)
+    return ((int) ' ');
+  return c;
 }
 
 /*==================================================================*/
 
 PRIVATE void
-err (char *message)
+err (interpreter * L, char *message)
 {
   L->error_number++;
   L->errors_occurred++;
@@ -3471,19 +5771,23 @@ err (char *message)
   if (L->parms->error_fp)
     {
       fprintf (L->parms->error_fp, "error %d at expression\n", L->error_number);
-      fprintf (L->parms->error_fp, "%s\n", L->input_expression);
+      fprintf (L->parms->error_fp, "%.*s\n",
+	       (L->input_length < INT_MAX) ? (int) L->input_length : INT_MAX,
+	       L->input_expression);
       fprintf (L->parms->error_fp, "%s", message);
       fflush (L->parms->error_fp);
     }
   
-  longjmp (RECOVER, 1);
+  longjmp (L->recover, 1);
 }
 
 /*==================================================================*/
 
 PUBLIC void
-status (FILE * fp)
+status (FILE * fp, interpreter * Interp)
 {
+  interpreter *L = Interp;
+
   if (fp != NULL)
     {
 
@@ -3602,13 +5906,236 @@ status (FILE * fp)
 	10			real number
 	11	   yes		identifier (variable or built-in name)
 	12			NIL code (technical)
-	13			list structure
-	14			empty list or end of list
-	15			arithmetics (+, -, *, /)
+	13			(unused)
+	14			(unused)
+	15			arithmetics (L, +, -, *, /)
 	16			relational (>, =, <)    
       
   ===========================================================================*/
 
+/*==================================================================*/
+
+/*
+ * corpus reader: hands out the programs of a file as views into a
+ * read-only mapping of it, for reduce_lambda_view(), without copying.
+ * A program is any number of lets followed by an eval, up to the ; of
+ * the eval; it may span lines, and eval( counts as eval.  A statement
+ * that starts with neither let nor eval is a bare expression and ends
+ * at the next ; or new line.  Lets left without an eval at the end
+ * make a program of their own, so that the error is reported.
+ * A statement starting with @ ends the corpus, as in lambda.test.
+ * Statement ends are found by memchr(), a vectorized scan in any
+ * decent C library.  Without a file, or if it cannot be mapped, the
+ * input is read in blocks into a buffer instead.
+ */
+
+PUBLIC lambda_corpus *
+lambda_corpus_open (const char *file)
+{
+  lambda_corpus *C;
+  struct stat info;
+  void *map;
+  int fd;
+
+  fd = file ? open (file, O_RDONLY) : STDIN_FILENO;
+  if (fd < 0)
+    return NULL;
+
+  C = (lambda_corpus *) space (sizeof (lambda_corpus));
+  C->fd = fd;
+  if (fstat (fd, &info) == 0 && S_ISREG (info.st_mode) && info.st_size > 0
+      && (map = mmap (NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED)
+    {
+      madvise (map, info.st_size, MADV_SEQUENTIAL);
+      C->text = (char *) map;
+      C->size = info.st_size;
+      C->mapped = TRUE;
+      C->at_end = TRUE;
+    }
+  else
+    {
+      C->capacity = BUFSIZ * 16;
+      C->text = (char *) space (sizeof (char) * C->capacity);
+    }
+  return C;
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * the next program, as *length characters at *program that stay valid
+ * until the next call; 'e' if it ends with an eval, 'b' if its last
+ * statement, at offset *body, is a bare expression, 0 at the end.
+ */
+
+PUBLIC int
+lambda_corpus_next (lambda_corpus * C, const char **program, size_t * length, size_t * body)
+{
+  size_t n;
+  size_t p;			/* offsets from C->next */
+  size_t start;
+  size_t statement;
+  size_t end;
+  size_t line;
+  char *text;
+  char *semicolon;
+  int kind;
+
+  p = 0;
+  start = LAMBDA_NUL;
+  for (;;)
+    {
+      do
+	{
+	  n = corpus_fill (C, p + 6);	/* enough to tell "eval " */
+	  text = C->text + C->next;
+	  while (p < n && (isspace (text[p]) || text[p] == ';'))
+	    p++;		/* empty statements too */
+	}
+      while (p + 6 > n && !C->at_end);
+
+      if ((p >= n || text[p] == '@') && start != LAMBDA_NUL)
+	{			/* lets without an eval: reduce_lambda_view() says so */
+	  while (p > start && isspace (text[p - 1]))
+	    p--;
+	  *program = text + start;
+	  *length = p - start;
+	  *body = 0;
+	  C->next += p;
+	  return 'e';
+	}
+      if (p >= n || text[p] == '@')
+	{			/* end */
+	  C->next = C->size;
+	  C->at_end = TRUE;
+	  return 0;
+	}
+      if (start == LAMBDA_NUL)
+	start = p;
+      statement = p;
+
+      if (key_word (text + p, n - p, "let") || key_word (text + p, n - p, "eval"))
+	{
+	  kind = (text[p] == 'e') ? 'e' : 0;	/* a let keeps going */
+	  end = corpus_find (C, p, ';');
+	  if (end == LAMBDA_NUL)
+	    {
+	      end = C->size - C->next - 1;	/* unterminated: parse() will say so */
+	      kind = 'e';
+	    }
+	  p = end + 1;
+	  if (kind == 0)
+	    continue;
+	}
+      else
+	{
+	  kind = 'b';
+	  line = corpus_find (C, p, '\n');
+	  if (line == LAMBDA_NUL)
+	    line = C->size - C->next;
+	  text = C->text + C->next;
+	  semicolon = (char *) memchr (text + p, ';', line - p);
+	  end = semicolon ? (size_t) (semicolon - text) : line;
+	  p = (end < C->size - C->next) ? end + 1 : end;	/* past the ; or new line */
+	  end--;		/* last character of the view */
+	}
+
+      *program = C->text + C->next + start;
+      *length = end + 1 - start;
+      *body = statement - start;
+      C->next += p;
+      return kind;
+    }
+}
+
+/*------------------------------------------------------------------*/
+
+PUBLIC void
+lambda_corpus_close (lambda_corpus * C)
+{
+  if (C->mapped)
+    munmap (C->text, C->size);
+  else
+    free (C->text);
+  if (C->fd != STDIN_FILENO)
+    close (C->fd);
+  free (C);
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * reads until need characters from C->next on are in the buffer, or the
+ * input ends; returns how many there are.  Offsets from C->next stay
+ * valid, the buffer itself may move.
+ */
+
+PRIVATE size_t
+corpus_fill (lambda_corpus * C, size_t need)
+{
+  ssize_t got;
+
+  while (C->size - C->next < need && !C->at_end)
+    {
+      if (C->next > 0)
+	{			/* drop what was handed out */
+	  memmove (C->text, C->text + C->next, C->size - C->next);
+	  C->size -= C->next;
+	  C->next = 0;
+	}
+      if (C->size == C->capacity)
+	{
+	  C->capacity *= 2;
+	  C->text = (char *) realloc (C->text, sizeof (char) * C->capacity);
+	  if (C->text == NULL)
+	    nrerror ("corpus_fill: allocation failure");
+	}
+      got = read (C->fd, C->text + C->size, C->capacity - C->size);
+      if (got <= 0)
+	C->at_end = TRUE;
+      else
+	C->size += got;
+    }
+  return C->size - C->next;
+}
+
+/*------------------------------------------------------------------*/
+
+/* offset of the first c at or after from, reading on as needed; LAMBDA_NUL if none */
+
+PRIVATE size_t
+corpus_find (lambda_corpus * C, size_t from, char c)
+{
+  char *found;
+  size_t n;
+
+  for (n = corpus_fill (C, from + 1); from < n; n = corpus_fill (C, n + 1))
+    {
+      found = (char *) memchr (C->text + C->next + from, c, n - from);
+      if (found)
+	return found - (C->text + C->next);
+      from = n;
+    }
+  return LAMBDA_NUL;
+}
+
+/*------------------------------------------------------------------*/
+
+/*
+ * TRUE if the n characters at text start with word as a whole token:
+ * what follows cannot continue an identifier, as get_token() reads it.
+ */
+
+PRIVATE boolean
+key_word (const char *text, size_t n, const char *word)
+{
+  size_t k;
+
+  k = strlen (word);
+  return n >= k && strncmp (text, word, k) == 0
+    && (n == k || !(isalnum ((unsigned char) text[k]) || text[k] == '$'));
+}
+
 /*-----------------------------------------------------------------*/
 
 /*
@@ -3663,6 +6190,129 @@ get_expression (FILE * fp)
 
 /*-----------------------------------------------------------------*/
 
+#ifndef NO_MAIN
+
+/*
+ * streaming mode (lambda -s [file]): reduces the programs of file, or
+ * of stdin, on one interpreter; see lambda_corpus_open() for the format.
+ * For every program one line is written:
+ *
+ *	normal form <tab> reductions <tab> cycles
+ *
+ * with !cycle_limit, !space_limit, !parse_error or !error in place of
+ * a missing normal form.  Error reports go to stderr.
+ */
+
+#define	  BLOCK    65536	/* output block size */
+
+struct block			/* block-buffered output */
+  {
+    FILE *fp;
+    size_t used;
+    char text[BLOCK];
+  };
+
+PRIVATE void
+stream (interpreter * Lambda, lambda_corpus * C, FILE * out)
+{
+  struct block *B;
+  const char *program;
+  char *bare;			/* "eval " spliced in */
+  size_t size;
+  size_t length;
+  size_t body;
+  int kind;
+
+  B = (struct block *) space (sizeof (struct block));
+  B->fp = out;
+  size = 256;
+  bare = (char *) space (sizeof (char) * size);
+
+  while ((kind = lambda_corpus_next (C, &program, &length, &body)) != 0)
+    {
+      if (kind == 'b')
+	{
+	  if (length + 7 > size)
+	    {
+	      size = 2 * (length + 7);
+	      bare = (char *) realloc (bare, sizeof (char) * size);
+	      if (bare == NULL)
+		nrerror ("stream: allocation failure");
+	    }
+	  memcpy (bare, program, body);
+	  memcpy (bare + body, "eval ", 5);
+	  memcpy (bare + body + 5, program + body, length - body);
+	  bare[length + 5] = ';';
+	  program = bare;
+	  length += 6;
+	}
+      stream_program (Lambda, program, length, B);
+    }
+
+  fwrite (B->text, 1, B->used, B->fp);
+  fflush (B->fp);
+  free (bare);
+  free (B);
+}
+
+/*-----------------------------------------------------------------*/
+
+PRIVATE void
+stream_program (interpreter * Lambda, const char *program, size_t length, struct block *B)
+{
+  static char *failure[] = { "", "!cycle_limit", "!space_limit", "!parse_error", "!error" };
+  char *normal_form;
+
+  normal_form = lambda_reduce_view (Lambda, program, length);
+  if (normal_form == NULL)
+    normal_form = failure[Lambda->status == REDUCE_NORMAL_FORM ? REDUCE_ERROR : Lambda->status];
+  put_text (B, normal_form, strlen (normal_form));
+  put_text (B, "\t", 1);
+  put_int (B, Lambda->reductions);
+  put_text (B, "\t", 1);
+  put_int (B, Lambda->cycles);
+  put_text (B, "\n", 1);
+}
+
+/*-----------------------------------------------------------------*/
+
+PRIVATE void
+put_text (struct block *B, const char *text, size_t n)
+{
+  if (B->used + n > BLOCK)
+    {
+      fwrite (B->text, 1, B->used, B->fp);
+      B->used = 0;
+      if (n > BLOCK)
+	{
+	  fwrite (text, 1, n, B->fp);
+	  return;
+	}
+    }
+  memcpy (B->text + B->used, text, n);
+  B->used += n;
+}
+
+/*-----------------------------------------------------------------*/
+
+PRIVATE void
+put_int (struct block *B, int value)
+{
+  char digits[12];
+  int i;
+
+  i = sizeof (digits);
+  do
+    {
+      digits[--i] = '0' + value % 10;
+      value /= 10;
+    }
+  while (value > 0);
+  put_text (B, digits + i, sizeof (digits) - i);
+}
+
+/*-----------------------------------------------------------------*/
+
 int
 main (int argc, char **argv)
 {
@@ -3673,16 +6323,23 @@ main (int argc, char **argv)
 
   interpreter *Lambda;
   parmsLambda *Parameters;
+  lambda_corpus *corpus;
   
   Parameters = (parmsLambda *) space (sizeof (parmsLambda));
+  lambda_default_parameters (Parameters);
 
-  Parameters->heap_size = 4000;	/* size of heap */
-  Parameters->cycle_limit = 100000; /* maximum number of cycles */
-  Parameters->symbol_table_size = 500;	/* size of symbol table */
-  Parameters->stack_size = 2000;  /* stack size */
-  Parameters->name_length = 10;	/* max length of identifiers */
-  Parameters->standard_variable = 'x';	/* name of standard variable */
-  Parameters->error_fp = stdout;  /* error report */
+  if (argc > 1 && strcmp (argv[1], "-s") == 0)
+    {
+      corpus = lambda_corpus_open ((argc > 2) ? argv[2] : NULL);
+      if (corpus == NULL)
+	nrerror ("lambda: cannot open input");
+      Parameters->error_fp = stderr;
+      Lambda = lambda_open (Parameters);
+      stream (Lambda, corpus, stdout);
+      lambda_close (Lambda);
+      lambda_corpus_close (corpus);
+      return 0;
+    }
 
   Lambda = initialize_lambda (Parameters);
 
@@ -3760,47 +6417,33 @@ main (int argc, char **argv)
 //     }
 //}
 
-PUBLIC interpreter * init_interpreter(){
-    const interpreter *Lambda;
-    parmsLambda *Parameters;
+#endif /* NO_MAIN */
 
-    Parameters = (parmsLambda *) space (sizeof (parmsLambda));
+PUBLIC interpreter *
+init_interpreter (void)
+{
+  return lambda_open (NULL);
+}
 
-    Parameters->heap_size = 4000;	/* size of heap */
-    Parameters->cycle_limit = 100000; /* maximum number of cycles */
-    Parameters->symbol_table_size = 500;	/* size of symbol table */
-    Parameters->stack_size = 2000;  /* stack size */
-    Parameters->name_length = 10;	/* max length of identifiers */
-    Parameters->standard_variable = 'x';	/* name of standard variable */
-    Parameters->error_fp = stdout;  /* error report */
+/*-----------------------------------------------------------------*/
 
-    Lambda = initialize_lambda (Parameters);
-    return Lambda;
-}
+/* one-shot convenience wrapper; the caller frees the result */
 
 PUBLIC char *
-reduce_expression (char *in) {
-    interpreter *global_lambda = init_interpreter();
-    char *standard_reduced;
-    char *reduced_expr;
-    char *bound_expr;
-    char *result;
-    // First reduce the expression
-    reduced_expr = reduce_lambda (in, global_lambda);
-    // Then standardize
-    standard_reduced = standardize(reduced_expr, global_lambda);
-    // Once Standardization has happened we can check for free variables. 
-    if (global_lambda->n_free_vars > 0){ // if there's free variables bind them and restandardize
-        bound_expr = bind_all_free_vars(standard_reduced, global_lambda);
-        result = standardize(bound_expr, global_lambda);
-    }
-    else{ // otherwise just return the result
-        result = standard_reduced;
+reduce_expression (char *in)
+{
+  interpreter *Lambda;
+  char *normal_form;
+  char *result = NULL;
+
+  Lambda = lambda_open (NULL);
+  normal_form = lambda_reduce_normalized (Lambda, in);
+  if (normal_form)
+    {
+      result = (char *) space (sizeof (char) * (strlen (normal_form) + 1));
+      strcpy (result, normal_form);
     }
-    
-    // free_interpreter(global_lambda);
-    // free(global_lambda);
-    // free(bound_expr);
-    // free(reduced_expr);
-    return result;
-}
\ No newline at end of file
+  lambda_close (Lambda);
+
+  return result;
+}
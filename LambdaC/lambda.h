@@ -7,11 +7,18 @@
 #ifndef	__LAMBDA_H
 #define	__LAMBDA_H
 
-typedef struct element
+#include <setjmp.h>
+#include <stdint.h>
+
+#define	  LAMBDA_NUL  ((size_t) -1)	/* input runs up to its NUL */
+
+typedef struct element		/* symbol table entry, see locate() */
   {
     char *symbol;
+    int length;
     int key;
-    int next;
+    unsigned int hash;		/* of the name */
+    int slot;			/* in symbol_slot */
   }
 element;
 
@@ -22,21 +29,55 @@ typedef struct pair
   }
 pair;
 
+typedef struct scratch		/* growable traversal stack */
+  {
+    int *item;
+    int size;
+  }
+scratch;
+
+typedef union heap_value	/* second operand, or value of a real */
+  {
+    int op2;
+    float alt;
+  }
+heap_value;
+
 typedef struct heap_node
   {
     int code;
     int op1;
-    boolean marker;
     int scope;
-    union
-      {
-	int op2;
-	float alt;
-      }
-    u;
+    heap_value u;
   }
 heap_node;
 
+#define	  FV_IDS   8		/* inline size of a free-variable set */
+
+typedef struct fv_set		/* free variables below a heap node */
+  {
+    int n;			/* number of ids, or FV_UNKNOWN/BUSY/MANY */
+    int id[FV_IDS];
+  }
+fv_set;
+
+typedef struct cons_entry	/* hash_cons() table slot */
+  {
+    int code;
+    int op1;
+    int op2;
+    int node;
+    unsigned int generation;	/* slot is empty unless current */
+  }
+cons_entry;
+
+typedef struct suffix_entry	/* taken_suffixes() table slot */
+  {
+    int value;
+    unsigned int generation;	/* slot is empty unless current */
+  }
+suffix_entry;
+
 typedef struct flags
   {
     int cycle_limit;
@@ -71,44 +112,152 @@ typedef struct flags
   }
 flags;
 
+typedef enum reduce_status	/* how a reduction ended */
+  {
+    REDUCE_NORMAL_FORM = 0,	/* normal form achieved */
+    REDUCE_CYCLE_LIMIT,		/* ran beyond cycle_limit */
+    REDUCE_SPACE_LIMIT,		/* ran out of heap */
+    REDUCE_PARSE_ERROR,		/* not a legal expression */
+    REDUCE_ERROR		/* any other error reported by err() */
+  }
+reduce_status;
+
+typedef struct memo_entry	/* see memo_probe() */
+  {
+    uint64_t key[2];		/* hash of the program text, see text_key() */
+    uint64_t hash;		/* canonical hash of the normal form */
+    char *normal_form;		/* NULL without one */
+    reduce_status status;
+    int reductions;
+    int cycles;
+    boolean referenced;		/* CLOCK bit */
+  }
+memo_entry;
+
 typedef struct parmsLambda	/* parameters */
   {
     int heap_size;		/* size of heap that houses computation */
     int cycle_limit;		/* maximum number of cycles */
 
-    int symbol_table_size;	/* size of symbol table */
+    int symbol_table_size;	/* initial size of symbol table; it grows */
     int stack_size;		/* stack size */
     int name_length;		/* max length of identifiers */
     char standard_variable;	/* name of standard variable; e.g 'x' */
 
     FILE *error_fp;		/* error report */
+    int free_var_cache;		/* cache free-variable sets for not_free() */
+    int max_heap_size;		/* heap doubles up to this size; 0: fixed */
+    int de_bruijn;		/* standardize by de Bruijn lookup, one walk */
+    int hash_cons;		/* share identical closed subterms after parse() */
+    int memo_size;		/* normal forms remembered per handle; 0: none */
+    int shared_memo;		/* slots of the process-wide memo; 0: not used */
+    int max_output;		/* longest printed expression; 0: no limit */
   }
 parmsLambda;
 
+typedef struct lambda_stats	/* see lambda_get_stats() */
+  {
+    int reductions;		/* of the last expression */
+    int cycles;
+    int heap_size;		/* current size, after any growth */
+    int collections;		/* since lambda_open() */
+    int heap_growths;
+    int cycle_limit_hits;
+    int space_limit_hits;
+    int shared;			/* subterms hash_cons() shared, last expression */
+    int memo_hits;		/* since lambda_open() */
+    int memo_misses;
+    int memo_evictions;
+    int memo_shared_hits;	/* answered by the process-wide memo */
+  }
+lambda_stats;
+
+typedef struct lambda_corpus	/* programs of a file, see lambda_corpus_next() */
+  {
+    char *text;			/* mapping of the file, or buffer */
+    size_t size;		/* characters in text */
+    size_t next;		/* where the next program starts */
+    size_t capacity;		/* of the buffer */
+    int fd;
+    boolean mapped;
+    boolean at_end;		/* nothing more to read */
+  }
+lambda_corpus;
+
 typedef struct interpreter
   {
     parmsLambda *parms;
 
+#ifdef SOA_HEAP
+    int *heap_code;		/* heap as structure of arrays */
+    int *heap_op1;
+    heap_value *heap_u;
+    int *heap_scope;		/* allocated by standardize() */
+#else
     heap_node *heap;
+#endif
+    unsigned int *mark;		/* walk marks, see new_epoch() */
+    unsigned int epoch;
+    unsigned int *gc_mark;	/* garbage collector marks, see garbage() */
+    unsigned int gc_epoch;
+    fv_set *fv;			/* free-variable cache, or NULL */
     pair *stack;
     element *table;
+    int symbols;		/* size of table, parms->symbol_table_size or more */
+    int *symbol_slot;		/* open addressing on the name: id */
+    int symbol_mask;
     flags error;
 
     char peek;
     char *letters;
     char *numbers;
+    unsigned char char_class[256];	/* CC_ bits of get_token(), by character */
     char *input_expression;
-    char *output_expression;
-    char *output_expression_ptr;
+    size_t input_length;	/* or LAMBDA_NUL, see reduce_lambda_view() */
+    size_t input_end;		/* characters known to be there, see scan_run() */
+    boolean terminate;		/* str_getc() ends the input with a ; */
+    char *output_expression;	/* grows, see print_text() */
+    size_t output_size;
+    size_t output_length;	/* of the expression printed last */
     char *current_expression;
-    char *new_name;
-    char **free_vars;
+    int *free_vars;		/* symbol ids, see free_vars_list() */
     int *identifiers;
+    int *symbol_mark;		/* SYM_ bits by symbol id */
+    suffix_entry *suffix;	/* numbers of free x<n>, see make_name() */
+    int suffix_size;
+    unsigned int suffix_generation;
+    int n_suffixes;
     int *path;
-    int group[98];
+    scratch track;		/* print_expression, alpha_standardize, garbage, hash_cons */
+    scratch trace;		/* not_free, recurve, scope, canonical_hash, hash_cons */
+    scratch names;		/* canonical_hash: free variables seen; hash_cons */
+    cons_entry *cons;		/* hash_cons() table, or NULL */
+    int cons_size;
+    unsigned int cons_generation;
+    int shared;
+    memo_entry *memo;		/* memo_size entries, or NULL */
+    int *memo_index;		/* open addressing on key[0]: entry + 1 */
+    int memo_mask;
+    int memo_used;
+    int memo_hand;		/* CLOCK hand */
+    int memo_hits;
+    int memo_misses;
+    int memo_evictions;
+    int memo_shared_hits;
+    boolean normalize;		/* reduce_lambda() prints standard_form() */
+    memo_entry *memo_answer;	/* the entry answering, or NULL */
+    memo_entry shared_answer;	/* copied out of the shared memo */
+    boolean memo_keyed;		/* memo_key is that of the current input */
+    uint64_t memo_key[2];
     int fresh;
     int root;
-    int _free;
+    int heap_size;		/* parms->heap_size, or more after grow_heap() */
+    int bump;			/* nodes below have not been used since clear() */
+    int bump_floor;		/* ... down to here */
+    int collections;
+    int heap_growths;
+    int sweep;			/* garbage() sweeps downward from here */
+    boolean fresh_marks;	/* nothing allocated since garbage() marked */
     int char_count;
     int n_identifiers;
     int n_free_vars;
@@ -118,8 +267,19 @@ typedef struct interpreter
     int cycles;
     int standard;
     int scope_offset;
+    int binders;		/* in scope, see print_binder() */
+    int binder_count;		/* printed so far */
     int garbage_collected;
     int busy;
+    int reserved;		/* symbols up to here are built-ins */
+    char *normal_form;		/* owned by lambda_reduce_normalized() */
+    reduce_status status;	/* outcome of lambda_reduce_normalized() */
+    uint64_t hash;		/* canonical hash of normal_form, or 0 */
+    boolean reducing;		/* FALSE while parsing */
+    char *program;		/* "eval ...;" for bare expressions */
+    int program_size;
+
+    jmp_buf recover;		/* err() returns to the public entry point */
 
     /* ---- reduction state */
 
@@ -137,7 +297,6 @@ typedef struct interpreter
     int k4;
     int position;
     int rest;
-    heap_node *node;
     boolean iterate;
     boolean done;
     boolean changed;
@@ -153,11 +312,36 @@ interpreter;
 extern interpreter *initialize_lambda (parmsLambda  * Params);
 extern void free_interpreter (interpreter * Interp);
 extern char *reduce_lambda (char *in, interpreter * Interp);
+extern char *reduce_lambda_view (const char *in, size_t length, interpreter * Interp);
 extern char *reduce_expression (char *in);
+extern void lambda_default_parameters (parmsLambda * Params);
+extern interpreter *lambda_open (const parmsLambda * Params);
+extern char *lambda_reduce_normalized (interpreter * Interp, char *in);
+extern char *lambda_reduce_view (interpreter * Interp, const char *in, size_t length);
+extern void lambda_reduce_batch (interpreter * Interp, const char **in, size_t n,
+				 char **out, reduce_status * st);
+extern void reduce_batch (const char **in, size_t n, char **out, reduce_status * st);
+extern char *lambda_reduce_packed (interpreter * Interp, const char *in, size_t n,
+				   size_t * out_len, reduce_status * st);
+extern void lambda_free (void *block);
+extern void lambda_get_stats (interpreter * Interp, lambda_stats * stats);
+extern const char *lambda_output (interpreter * Interp, size_t * length);
+extern uint64_t lambda_canonical_hash (interpreter * Interp, int root);
+extern uint64_t lambda_normal_form_hash (interpreter * Interp);
+extern void lambda_reduce_parallel (const parmsLambda * parms, const char **in, size_t n,
+				    char **out, reduce_status * st, int threads);
+extern char *lambda_reduce_packed_parallel (const parmsLambda * parms, const char *in,
+					    size_t n, size_t * out_len,
+					    reduce_status * st, int threads);
+extern void lambda_close (interpreter * Interp);
+extern lambda_corpus *lambda_corpus_open (const char *file);
+extern int lambda_corpus_next (lambda_corpus * C, const char **program, size_t * length,
+			       size_t * body);
+extern void lambda_corpus_close (lambda_corpus * C);
 
 extern char *standardize (char *expression, interpreter * Interp);
 extern char *bind_all_free_vars (char *expression, interpreter * Interp);
 extern int  Free_Variables (char *expression, interpreter * Interp);
-extern void status (FILE * fp);
+extern void status (FILE * fp, interpreter * Interp);
 
 #endif /* __LAMBDA_H */
@@ -150,24 +150,32 @@ hamming (char *s1, char *s2)
 PUBLIC char *
 get_line (FILE * fp)		/* reads lines of arbitrary length from fp */
 {
-  char s[512], *line, *cp;
+  char *line;
+  size_t length, size;
 
-  line = NULL;
-  do
+  size = 512;
+  line = (char *) space (size);
+  length = 0;
+  while (fgets (line + length, size - length, fp) != NULL)
     {
-      if (fgets (s, 512, fp) == NULL)
-	break;
-      cp = strchr (s, '\n');
-      if (cp != NULL)
-	*cp = '\0';
+      length += strlen (line + length);
+      if (length > 0 && line[length - 1] == '\n')
+	{
+	  line[--length] = '\0';
+	  return line;
+	}
+      if (length + 1 < size)
+	break;			/* last line, without new line */
+      size *= 2;		/* geometric growth keeps long lines linear */
+      line = (char *) realloc (line, size);
       if (line == NULL)
-	line = (char *) space (strlen (s) + 1);
-      else
-	line = (char *) realloc (line, strlen (s) + strlen (line) + 1);
-      strcat (line, s);
+	nrerror ("get_line: allocation failure");
+    }
+  if (length == 0)
+    {
+      free (line);
+      return NULL;
     }
-  while (cp == NULL);
-
   return line;
 }
 
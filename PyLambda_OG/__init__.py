@@ -1 +1 @@
-from .pylambda import reduce_lambda
\ No newline at end of file
+from .pylambda import reduce_lambda, reduce_many, Interpreter
\ No newline at end of file
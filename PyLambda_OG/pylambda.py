@@ -1,16 +1,152 @@
 import ctypes
 import os
+import threading
 
 _lambda = ctypes.CDLL(os.path.abspath(os.path.join(__file__,'../../LambdaC/lambda.so')))
 _lambda.reduce_expression.argtypes = (ctypes.c_char_p,)
 _lambda.reduce_expression.restype = ctypes.c_char_p
 
+class ParmsLambda(ctypes.Structure):
+    """Mirror of parmsLambda in LambdaC/lambda.h"""
+    _fields_ = [
+        ("heap_size", ctypes.c_int),
+        ("cycle_limit", ctypes.c_int),
+        ("symbol_table_size", ctypes.c_int),
+        ("stack_size", ctypes.c_int),
+        ("name_length", ctypes.c_int),
+        ("standard_variable", ctypes.c_char),
+        ("error_fp", ctypes.c_void_p),
+        ("free_var_cache", ctypes.c_int),
+        ("max_heap_size", ctypes.c_int),
+        ("de_bruijn", ctypes.c_int),
+        ("hash_cons", ctypes.c_int),
+        ("memo_size", ctypes.c_int),
+        ("shared_memo", ctypes.c_int),
+        ("max_output", ctypes.c_int),
+    ]
+
+class LambdaStats(ctypes.Structure):
+    """Mirror of lambda_stats in LambdaC/lambda.h"""
+    _fields_ = [(name, ctypes.c_int) for name in (
+        "reductions", "cycles", "heap_size", "collections", "heap_growths",
+        "cycle_limit_hits", "space_limit_hits", "shared",
+        "memo_hits", "memo_misses", "memo_evictions", "memo_shared_hits")]
+
+_lambda.lambda_default_parameters.argtypes = (ctypes.POINTER(ParmsLambda),)
+_lambda.lambda_default_parameters.restype = None
+_lambda.lambda_open.argtypes = (ctypes.POINTER(ParmsLambda),)
+_lambda.lambda_open.restype = ctypes.c_void_p
+_lambda.lambda_reduce_normalized.argtypes = (ctypes.c_void_p, ctypes.c_char_p)
+_lambda.lambda_reduce_normalized.restype = ctypes.c_char_p
+_lambda.lambda_reduce_view.argtypes = (ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t)
+_lambda.lambda_reduce_view.restype = ctypes.c_char_p
+_lambda.lambda_close.argtypes = (ctypes.c_void_p,)
+_lambda.lambda_close.restype = None
+_lambda.lambda_reduce_packed.argtypes = (ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t,
+                                         ctypes.POINTER(ctypes.c_size_t), ctypes.POINTER(ctypes.c_int))
+_lambda.lambda_reduce_packed.restype = ctypes.c_void_p
+_lambda.lambda_reduce_packed_parallel.argtypes = (ctypes.POINTER(ParmsLambda), ctypes.c_char_p,
+                                                  ctypes.c_size_t, ctypes.POINTER(ctypes.c_size_t),
+                                                  ctypes.POINTER(ctypes.c_int), ctypes.c_int)
+_lambda.lambda_reduce_packed_parallel.restype = ctypes.c_void_p
+_lambda.lambda_get_stats.argtypes = (ctypes.c_void_p, ctypes.POINTER(LambdaStats))
+_lambda.lambda_get_stats.restype = None
+_lambda.lambda_output.argtypes = (ctypes.c_void_p, ctypes.POINTER(ctypes.c_size_t))
+_lambda.lambda_output.restype = ctypes.c_void_p
+_lambda.lambda_normal_form_hash.argtypes = (ctypes.c_void_p,)
+_lambda.lambda_normal_form_hash.restype = ctypes.c_uint64
+_lambda.lambda_free.argtypes = (ctypes.c_void_p,)
+_lambda.lambda_free.restype = None
+
+# reduce_status in LambdaC/lambda.h
+NORMAL_FORM, CYCLE_LIMIT, SPACE_LIMIT, PARSE_ERROR, ERROR = range(5)
+
+class Interpreter:
+    """A reusable LambdaC interpreter; keyword arguments override parmsLambda defaults."""
+
+    def __init__(self, **params):
+        parms = ParmsLambda()
+        _lambda.lambda_default_parameters(ctypes.byref(parms))
+        for key, value in params.items():
+            if key == "standard_variable":
+                value = bytes(value, 'utf-8')
+            setattr(parms, key, value)
+        self._parms = parms
+        self._handle = _lambda.lambda_open(ctypes.byref(parms))
+
+    def reduce(self, expr, return_hash=False):
+        """Normal form of expr, None if there is none.
+
+        return_hash also returns the normal form's alpha-invariant hash (0 without one),
+        so alpha-equivalence checks need no string comparison.
+        """
+        full_exprs = f"eval {expr};"
+        result = _lambda.lambda_reduce_normalized(self._handle, bytes(full_exprs, 'utf-8'))
+        if result is not None:
+            result = str(result, 'utf-8')
+        if return_hash:
+            return result, _lambda.lambda_normal_form_hash(self._handle)
+        return result
+
+    def reduce_many(self, exprs, return_status=False, threads=1):
+        """Reduce a list of expressions in one call; None marks items without a normal form.
+
+        threads other than 1 spreads the batch over that many worker interpreters
+        (0 means one per processor); ctypes drops the GIL for the whole call.
+        """
+        n = len(exprs)
+        packed = b"".join(bytes(expr, 'utf-8') + b"\0" for expr in exprs)
+        out_len = ctypes.c_size_t()
+        status = (ctypes.c_int * n)()
+        if threads == 1:
+            out = _lambda.lambda_reduce_packed(self._handle, packed, n, ctypes.byref(out_len), status)
+        else:
+            out = _lambda.lambda_reduce_packed_parallel(ctypes.byref(self._parms), packed, n,
+                                                        ctypes.byref(out_len), status, threads)
+        try:
+            fields = ctypes.string_at(out, out_len.value).split(b"\0")[:n]
+        finally:
+            _lambda.lambda_free(out)
+        results = [str(field, 'utf-8') if code == NORMAL_FORM else None
+                   for field, code in zip(fields, status)]
+        if return_status:
+            return results, list(status)
+        return results
+
+    def stats(self):
+        """Counters of the last reduction and of the handle's lifetime, as a dict."""
+        stats = LambdaStats()
+        _lambda.lambda_get_stats(self._handle, ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in LambdaStats._fields_}
+
+    def close(self):
+        if getattr(self, "_handle", None):
+            _lambda.lambda_close(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+# one handle per Python thread: ctypes drops the GIL inside LambdaC
+_default = threading.local()
+
+def _interpreter():
+    interp = getattr(_default, "interp", None)
+    if interp is None:
+        interp = _default.interp = Interpreter()
+    return interp
+
 def reduce_lambda(expr):
-    full_exprs = f"eval {expr};"
-    result = _lambda.reduce_expression(ctypes.c_char_p(bytes(full_exprs, 'utf-8')))
-    str_result = str(result, 'utf-8')
+    return _interpreter().reduce(expr)
 
-    return str_result
+def reduce_many(exprs, return_status=False, threads=1):
+    return _interpreter().reduce_many(exprs, return_status, threads)
 
 if __name__ == "__main__":
     expr = "\\x.(y)x"
@@ -0,0 +1,45 @@
+import ctypes
+import os
+import pytest
+from PyLambda_OG.pylambda import _lambda
+
+_libc = ctypes.CDLL(None)
+_libc.free.argtypes = (ctypes.c_void_p,)
+_lambda.reduce_lambda.argtypes = (ctypes.c_char_p, ctypes.c_void_p)
+_lambda.reduce_lambda.restype = ctypes.c_void_p
+
+LAMBDAC = os.path.join(os.path.dirname(__file__), '..', 'LambdaC')
+
+def load_suite():
+    """(program, expected) pairs from lambda.test/lambda.res, split like get_expression()"""
+    programs = []
+    expr = ""
+    with open(os.path.join(LAMBDAC, 'lambda.test')) as fp:
+        for line in fp:
+            line = line.rstrip('\n')
+            if line.startswith('@'):
+                break
+            expr += line
+            if "eval" in line:
+                programs.append(expr)
+                expr = ""
+    with open(os.path.join(LAMBDAC, 'lambda.res')) as fp:
+        results = [line.rstrip('\n') for line in fp]
+    return list(zip(programs, results))
+
+def _reduce_raw(interp, program):
+    """reduce_lambda() on an Interpreter: the normal form, not standardized"""
+    result = _lambda.reduce_lambda(bytes(program, 'utf-8'), interp._handle)
+    if not result:
+        return None
+    value = str(ctypes.string_at(result), 'utf-8')
+    _libc.free(result)
+    return value
+
+@pytest.fixture(scope="session")
+def lambda_suite():
+    return load_suite()
+
+@pytest.fixture
+def reduce_raw():
+    return _reduce_raw
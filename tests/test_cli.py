@@ -0,0 +1,50 @@
+import os
+import subprocess
+import pytest
+from PyLambda_OG.pylambda import _lambda
+import PyLambda_OG as PL
+from conftest import LAMBDAC
+
+@pytest.fixture(scope="module")
+def lambda_cli():
+    if subprocess.run(["make", "-C", LAMBDAC, "lambda"], capture_output=True).returncode:
+        pytest.skip("cannot build the lambda executable")
+    return os.path.join(LAMBDAC, "lambda")
+
+def test_stream_suite(lambda_cli, lambda_suite):
+    out = subprocess.run([lambda_cli, "-s", os.path.join(LAMBDAC, "lambda.test")],
+                         capture_output=True, text=True).stdout.splitlines()
+    assert len(out) == len(lambda_suite)
+    with PL.Interpreter() as interp:
+        for line, (program, _) in zip(out, lambda_suite):
+            normal_form = _lambda.lambda_reduce_normalized(interp._handle, bytes(program, 'utf-8'))
+            stats = interp.stats()
+            assert line == f"{str(normal_form, 'utf-8')}\t{stats['reductions']}\t{stats['cycles']}"
+
+def test_stream_bare_expressions(lambda_cli):
+    text = "(\\x.x)y\n\\x.(x)z;(\\x.(x)x)\\x.(x)x\nlet I _ \\x.x;\neval (I)q;\n\\x.\n"
+    out = subprocess.run([lambda_cli, "-s"], input=text, capture_output=True, text=True).stdout
+    lines = [line.split("\t")[0] for line in out.splitlines()]
+    assert lines == ["\\x1.x1", "\\x1.\\x2.(x2)x1", "!cycle_limit", "\\x1.x1", "!parse_error"]
+
+def test_stream_key_words(lambda_cli):
+    programs = ["eval(\\x.x)z;", "eval(\\x.\n x)z;", "let I _ \\x.x;\nlet K _\\x.\\y.x;eval((K)I)\nq;"]
+    out = subprocess.run([lambda_cli, "-s"], input="\n".join(programs) + "\nevaluate\n",
+                         capture_output=True, text=True).stdout.splitlines()
+    assert len(out) == len(programs) + 1
+    with PL.Interpreter() as interp:
+        for line, program in zip(out, programs):
+            text = bytes(program, 'utf-8')
+            normal_form = _lambda.lambda_reduce_view(interp._handle, text, len(text))
+            stats = interp.stats()
+            assert stats["reductions"] > 0
+            assert line == f"{str(normal_form, 'utf-8')}\t{stats['reductions']}\t{stats['cycles']}"
+    assert out[-1] == "\\x1.x1\t0\t1"
+
+def test_stream_one_line_per_program(lambda_cli):
+    text = "eval(\\x.\n x)z;  \\x.x\n(\\x.x)y; let I _ \\x.x;\neval\n(I)q;\nlet K _ \\x.\\y.x;\n"
+    for tail in ["", "@\neval x;\n"]:
+        out = subprocess.run([lambda_cli, "-s"], input=text + tail,
+                             capture_output=True, text=True).stdout.splitlines()
+        assert [line.split("\t")[0] for line in out] == \
+            ["\\x1.x1", "\\x1.x1", "\\x1.x1", "\\x1.x1", "!parse_error"]
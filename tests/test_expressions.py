@@ -11,4 +11,8 @@ def test_expression_2():
 
 def test_expression_TT():
     val = PL.reduce_lambda("(\\x.\\y.x)\\z.\\w.z")
-    assert val == "\\x1.\\x2.\\x3.x2" # Is this right??
\ No newline at end of file
+    assert val == "\\x1.\\x2.\\x3.x2" # Is this right??
+
+def test_shared_lists():
+    assert PL.reduce_lambda("(\\x.[x,[x,x]])[1,[2,3]]") == "[[1,[2,3]],[[1,[2,3]],[1,[2,3]]]]"
+    assert PL.reduce_lambda("(\\x.((&)x)x)[1]") == "[[1],1]"
@@ -0,0 +1,293 @@
+import ctypes
+import random
+import pytest
+import PyLambda_OG as PL
+from PyLambda_OG.pylambda import _lambda
+
+EXPRESSIONS = [
+    "\\x1.x1",
+    "(\\x.\\y.x)\\z.\\w.z",
+    "((\\x.\\y.(x)y)A)B",
+    "(\\x.(\\y.(x)(y)y)\\z.(x)(z)z)(\\u.\\v.u)w",
+    "(((\\x.\\y.\\z.((x)z)(y)z)\\u.\\v.u)\\s.s)t",
+    "(\\x.(x)x)\\x.(x)x",
+]
+
+_libc = ctypes.CDLL(None)
+_libc.free.argtypes = (ctypes.c_void_p,)
+for _name in ("standardize", "bind_all_free_vars"):
+    getattr(_lambda, _name).argtypes = (ctypes.c_void_p, ctypes.c_void_p)
+    getattr(_lambda, _name).restype = ctypes.c_void_p
+
+def one_shot(expr):
+    result = _lambda.reduce_expression(bytes(f"eval {expr};", 'utf-8'))
+    return None if result is None else str(result, 'utf-8')
+
+def test_handle_matches_one_shot():
+    with PL.Interpreter() as interp:
+        for _ in range(3):
+            for expr in EXPRESSIONS:
+                assert interp.reduce(expr) == one_shot(expr)
+
+def test_no_normal_form():
+    with PL.Interpreter(cycle_limit=1000) as interp:
+        assert interp.reduce("(\\x.(x)x)\\x.(x)x") is None
+        assert interp.reduce("\\x2.x2") == "\\x1.x1"
+
+def test_symbol_table_does_not_fill_up():
+    with PL.Interpreter(symbol_table_size=100) as interp:
+        for i in range(500):
+            assert interp.reduce(f"(\\x.x)v{i}") == "\\x1.x1"
+
+def test_symbol_table_grows():
+    n = 1000
+    term = "(" * (n - 1) + "v0" + "".join(f")v{i}" for i in range(1, n))
+    standard = "".join(f"\\x{k}." for k in range(1, n + 1)) + \
+        "(" * (n - 1) + f"x{n}" + "".join(f")x{k}" for k in range(n - 1, 0, -1))
+    with PL.Interpreter(symbol_table_size=50, heap_size=100000, stack_size=10000,
+                        cycle_limit=10**7) as interp:
+        assert interp.reduce(term) == standard
+
+def test_name_length():
+    for name_length in (4, 16):
+        with PL.Interpreter(name_length=name_length) as interp:
+            assert interp.reduce("(add)[1,2,3]") == "6"
+            assert interp.reduce("(\\abcdefghijklmnopq.abcdefghijklmnopXYZ)q") == "\\x1.x1"
+
+def test_deep_nesting(reduce_raw):
+    depth = 2500
+    body = "(" * depth + "f" + ")a" * depth
+    with PL.Interpreter(heap_size=100000, stack_size=20000, cycle_limit=10**8) as interp:
+        assert reduce_raw(interp, f"eval (\\f.{body})g;") == body.replace("f", "g", 1)
+        standard = "\\x1.\\x2." + body.replace("f", "x2", 1).replace("a", "x1")
+        assert len(standard) > 5000 and interp.reduce(f"(\\f.{body})g") == standard
+
+def test_reduce_many_matches_reduce():
+    with PL.Interpreter() as interp:
+        expected = [interp.reduce(expr) for expr in EXPRESSIONS]
+    assert PL.reduce_many(EXPRESSIONS) == expected
+
+def test_reduce_many_status():
+    exprs = ["(\\x.x)y", "(\\x.(x)x)\\x.(x)x", "\\x.", "((\\x.(x)x)\\x.(x)x)y"]
+    with PL.Interpreter(cycle_limit=1000) as interp:
+        results, status = interp.reduce_many(exprs, return_status=True)
+        assert results == ["\\x1.x1", None, None, None]
+        assert status[:3] == [PL.pylambda.NORMAL_FORM, PL.pylambda.CYCLE_LIMIT,
+                              PL.pylambda.PARSE_ERROR]
+    with PL.Interpreter(heap_size=100) as interp:
+        results, status = interp.reduce_many(["(\\x.(x)x)\\x.((x)x)x"], return_status=True)
+        assert results == [None] and status == [PL.pylambda.SPACE_LIMIT]
+
+def test_free_var_cache(lambda_suite, reduce_raw):
+    with PL.Interpreter(free_var_cache=1) as interp:
+        for _ in range(2):
+            for program, expected in lambda_suite:
+                assert reduce_raw(interp, program) == expected
+
+def test_small_heap_collects(lambda_suite, reduce_raw):
+    with PL.Interpreter(heap_size=1500) as interp:
+        for program, expected in lambda_suite:
+            assert reduce_raw(interp, program) == expected
+
+def test_heap_grows(lambda_suite, reduce_raw):
+    with PL.Interpreter(heap_size=100, max_heap_size=100000) as interp:
+        for program, expected in lambda_suite:
+            assert reduce_raw(interp, program) == expected
+        stats = interp.stats()
+        assert stats["heap_growths"] > 0 and 100 < stats["heap_size"] <= 100000
+    with PL.Interpreter(heap_size=100, max_heap_size=150) as interp:
+        results, status = interp.reduce_many(["(\\x.(x)x)\\x.((x)x)x"], return_status=True)
+        assert results == [None] and status == [PL.pylambda.SPACE_LIMIT]
+        assert interp.stats()["heap_size"] == 150
+
+def test_canonical_hash(lambda_suite):
+    with PL.Interpreter() as interp:
+        assert interp.reduce("\\x.(x)y", return_hash=True)[1] == \
+            interp.reduce("((\\u.\\v.\\w.(w)u)a)b", return_hash=True)[1]
+        assert interp.reduce("(\\x.(x)x)\\x.(x)x", return_hash=True) == (None, 0)
+        hashes = {}
+        for program, _ in lambda_suite:
+            normal_form = _lambda.lambda_reduce_normalized(interp._handle, bytes(program, 'utf-8'))
+            if normal_form is not None:
+                hashes.setdefault(normal_form, set()).add(_lambda.lambda_normal_form_hash(interp._handle))
+        assert all(len(h) == 1 for h in hashes.values())
+        assert len({h for s in hashes.values() for h in s}) == len(hashes)
+
+def test_de_bruijn_standardize(lambda_suite):
+    with PL.Interpreter() as scoped, PL.Interpreter(de_bruijn=1) as indexed:
+        for program, _ in lambda_suite + [(f"eval {expr};", None) for expr in EXPRESSIONS]:
+            program = bytes(program, 'utf-8')
+            assert _lambda.lambda_reduce_normalized(indexed._handle, program) == \
+                _lambda.lambda_reduce_normalized(scoped._handle, program)
+
+def test_hash_cons(lambda_suite, reduce_raw):
+    with PL.Interpreter(hash_cons=1) as interp:
+        for program, expected in lambda_suite:
+            assert reduce_raw(interp, program) == expected
+        s = "\\a.\\b.\\c.((a)c)(b)c"
+        assert interp.reduce(f"((({s})\\x.x)({s})x)y") == one_shot(f"((({s})\\x.x)({s})x)y")
+        assert interp.stats()["shared"] > 0
+
+def test_memo(lambda_suite):
+    with PL.Interpreter(memo_size=16) as memo, PL.Interpreter() as plain:
+        for _ in range(2):
+            for program, _ in lambda_suite:
+                program = bytes(program, 'utf-8')
+                assert _lambda.lambda_reduce_normalized(memo._handle, program) == \
+                    _lambda.lambda_reduce_normalized(plain._handle, program)
+                assert memo.stats()["reductions"] == plain.stats()["reductions"]
+        stats = memo.stats()
+        assert stats["memo_evictions"] > 0
+        hits = stats["memo_hits"]
+        assert memo.reduce("((\\x.\\y.(y)x)a)b") == memo.reduce("((\\x.\\y.(y)x)a)b")
+        assert memo.stats()["memo_hits"] == hits + 1
+        memo.reduce("((\\u.\\v.(v)u)c)d")  # alpha-variants are not merged
+        assert memo.stats()["memo_hits"] == hits + 1
+
+def random_terms(seed, n):
+    """varied small terms: shadowing, free x<n> names, lists, numbers, key words"""
+    rng = random.Random(seed)
+    names = ["x", "y", "u", "x1", "x2", "x3", "a", "add"]
+
+    def term(depth, bound):
+        r = rng.random()
+        if depth <= 0 or r < 0.3:
+            if bound and rng.random() < 0.5:
+                return rng.choice(bound)
+            return rng.choice(names + ["1", "2.5", "[]"])
+        if r < 0.55:
+            v = rng.choice(names[:-1])
+            return f"\\{v}.{term(depth - 1, bound + [v])}"
+        if r < 0.8:
+            return f"({term(depth - 1, bound)}){term(depth - 1, bound)}"
+        return "[" + ",".join(term(depth - 1, bound) for _ in range(rng.randint(1, 3))) + "]"
+
+    return [term(rng.randint(1, 6), []) for _ in range(n)]
+
+def test_memo_matches_plain(lambda_suite):
+    exprs = ["[y]", "\\g.[g]", "\\c.\\x.\\b.(u)c", "\\f.\\y.\\z.(x3)f"] + random_terms(1, 1500)
+    programs = [program for program, _ in lambda_suite] + [f"eval {expr};" for expr in exprs]
+    with PL.Interpreter(memo_size=64, cycle_limit=2000, error_fp=None) as memo, \
+         PL.Interpreter(cycle_limit=2000, error_fp=None) as plain:
+        for program in programs + programs[::-1]:
+            program = bytes(program, 'utf-8')
+            assert _lambda.lambda_reduce_normalized(memo._handle, program) == \
+                _lambda.lambda_reduce_normalized(plain._handle, program)
+        assert memo.stats()["memo_hits"] > 0
+
+def test_shared_memo(lambda_suite):
+    programs = [program for program, _ in lambda_suite]
+    with PL.Interpreter() as plain:
+        expected = [_lambda.lambda_reduce_normalized(plain._handle, bytes(p, 'utf-8')) for p in programs]
+    with PL.Interpreter(shared_memo=1024) as first, PL.Interpreter(shared_memo=1024) as second:
+        for program in programs:
+            _lambda.lambda_reduce_normalized(first._handle, bytes(program, 'utf-8'))
+        results = [_lambda.lambda_reduce_normalized(second._handle, bytes(p, 'utf-8')) for p in programs]
+        assert results == expected
+        assert second.stats()["memo_shared_hits"] > 0
+    with PL.Interpreter(shared_memo=1024) as interp:
+        assert interp.reduce_many(EXPRESSIONS * 20, threads=4) == \
+            [one_shot(expr) for expr in EXPRESSIONS * 20]
+    with PL.Interpreter(shared_memo=1024, cycle_limit=100) as short, \
+         PL.Interpreter(shared_memo=1024) as long:
+        succ_six = "(((\\n.\\f.\\x.(f)((n)f)x)\\f.\\x.(f)(f)(f)(f)(f)(f)x)g)a"
+        assert short.reduce(succ_six) is None
+        assert long.reduce(succ_six) == one_shot(succ_six)
+
+def test_shared_memo_parameters():
+    term = "((\\x.\\y.((y)x)(y)x)a)b"
+    with PL.Interpreter(shared_memo=1024, standard_variable='y') as other, \
+         PL.Interpreter(shared_memo=1024) as default:
+        assert other.reduce(term) == "\\y1.\\y2.((y2)y1)(y2)y1"
+        assert default.reduce(term) == "\\x1.\\x2.((x2)x1)(x2)x1"
+    with PL.Interpreter(shared_memo=1024, heap_size=20, error_fp=None) as small:
+        results, status = small.reduce_many([term], return_status=True)
+        assert results == [None] and status == [PL.pylambda.SPACE_LIMIT]
+    exprs = random_terms(2, 5000)
+    with PL.Interpreter(cycle_limit=2000, error_fp=None) as plain:
+        expected = plain.reduce_many(exprs, return_status=True)
+    with PL.Interpreter(shared_memo=1024, cycle_limit=2000, error_fp=None) as interp:
+        assert interp.reduce_many(exprs, return_status=True, threads=8) == expected
+
+def test_reduce_view():
+    program = b"let K _ \\x.\n\\y.x;\teval ((K)a)b;"
+    with PL.Interpreter() as interp:
+        for tail in [b"", b"eval x", b"\n@@@"]:
+            text = program + tail
+            assert _lambda.lambda_reduce_view(interp._handle, text, len(program)) == b"\\x1.x1"
+
+def test_long_tokens():
+    with PL.Interpreter() as interp:
+        # identifiers are cut to name_length characters
+        assert interp.reduce("(\\abcdefghijklmnop.abcdefghijXYZ)q") == "\\x1.x1"
+        assert interp.reduce(f"(({'v' * 40})(abcdefghijk)12345678)3.25") == \
+            "\\x1.\\x2.((x2)(x1)12345678)3.25000"
+
+def test_output_grows(reduce_raw):
+    term = "(" * 39 + "abcdefghij" + ")abcdefghij" * 39
+    with PL.Interpreter(heap_size=200) as interp:
+        assert reduce_raw(interp, f"eval {term};") == term
+        length = ctypes.c_size_t()
+        text = _lambda.lambda_output(interp._handle, ctypes.byref(length))
+        assert ctypes.string_at(text, length.value) == bytes(term, 'utf-8')
+        assert reduce_raw(interp, "eval ((*)((-)2)7)3;") == "-15"
+    with PL.Interpreter(max_output=len(term) - 1, error_fp=None) as interp:
+        results, status = interp.reduce_many([term], return_status=True)
+        assert results == [None] and status == [PL.pylambda.ERROR]
+
+def through_text(interp, program):
+    """the normal form the long way: standardize() and bind_all_free_vars() on printed text"""
+    def call(function, text):
+        result = function(text, interp._handle)
+        value = None if not result else ctypes.string_at(result)
+        _libc.free(result)
+        return value
+    text = _lambda.reduce_lambda(bytes(program, 'utf-8'), interp._handle)
+    standard = call(_lambda.standardize, text)
+    _libc.free(text)
+    bound = standard and call(_lambda.bind_all_free_vars, standard)
+    return call(_lambda.standardize, bound) if bound else standard
+
+def test_standard_form_matches_text(lambda_suite):
+    tricky = ["(\\x.\\y.(x)y)y", "(\\x.[x,x])\\y.(y)z", "((/)2.0)7.0", "((-)2)7", "((&)1)a",
+              "(\\a.\\b.[(b)a,$1])c", "(x3)\\u.[u,(u)x1]", "(\\add.(add)x)y",
+              "(x3)\\abcdefghijk.(z)([eval,[abcdefghijk,abcdefghijk]])\\y.(x3)y"]
+    programs = [program for program, _ in lambda_suite] + \
+        [f"eval {expr};" for expr in EXPRESSIONS + tricky]
+    with PL.Interpreter(error_fp=None) as interp:
+        for program in programs:
+            assert _lambda.lambda_reduce_normalized(interp._handle, bytes(program, 'utf-8')) == \
+                through_text(interp, program)
+
+def test_free_variables_under_shadowing():
+    _lambda.Free_Variables.argtypes = (ctypes.c_char_p, ctypes.c_void_p)
+    cases = [(b"\\y.((y)z)\\z.(\\y.(y)w)(z)y", b"\\w.\\z.\\y.((y)z)\\z.(\\y.(y)w)(z)y", 1),
+             (b"(\\a.\\a.(a)b)(a)\\b.b", b"\\b.\\a.(\\a.\\a.(a)b)(a)\\b.b", 1),
+             (b"\\x.\\y.(y)x", None, 0)]
+    with PL.Interpreter(error_fp=None) as interp:
+        for term, bound, free in cases:
+            result = _lambda.bind_all_free_vars(term, interp._handle)
+            assert (ctypes.string_at(result) or None) == bound
+            _libc.free(result)
+            assert _lambda.Free_Variables(term, interp._handle) == free
+
+def test_standard_names_step_around_free_ones():
+    cases = [(b"\\a.((x1)x3)\\b.\\c.((a)b)\\d.(d)x2", b"\\x4.((x1)x3)\\x5.\\x6.((x4)x5)\\x7.(x7)x2"),
+             (b"\\a.((x01)x2)\\b.(b)b", b"\\x1.((x01)x2)\\x3.(x3)x3")]
+    with PL.Interpreter(error_fp=None) as interp:
+        for term, standard in cases:
+            result = _lambda.standardize(term, interp._handle)
+            assert ctypes.string_at(result) == standard
+            _libc.free(result)
+
+def test_normal_form_larger_than_heap():
+    # the free x1 sends the normal form back through standardize(), which
+    # must not collect the graph it is still parsing
+    term = "(\\u.(((u)(u)u)(\\x1.x1)(u)u)\\x1.\\z.u)(\\x1.(((x1)x1)(x1)a)(x1)\\x3.x1)" \
+        "(x1)(((u)x)a)((a)c)\\x1.x1"
+    with PL.Interpreter(heap_size=400, error_fp=None) as interp:
+        results, status = interp.reduce_many([term], return_status=True)
+        assert results == [None] and status == [PL.pylambda.SPACE_LIMIT]
+        assert interp.reduce("(\\x.x)y") == "\\x1.x1"
+    with PL.Interpreter(heap_size=400, max_heap_size=100000) as interp:
+        assert interp.reduce(term) == one_shot(term)
@@ -0,0 +1,59 @@
+import threading
+import pytest
+import PyLambda_OG as PL
+
+def run_suite(suite, reduce_raw, rounds, failures):
+    with PL.Interpreter() as interp:
+        for _ in range(rounds):
+            for program, expected in suite:
+                result = reduce_raw(interp, program)
+                if result != expected:
+                    failures.append((program, expected, result))
+
+def test_suite_sequential(lambda_suite, reduce_raw):
+    failures = []
+    run_suite(lambda_suite, reduce_raw, 1, failures)
+    assert failures == []
+
+@pytest.mark.parametrize("n_threads", [2, 8])
+def test_suite_threads(lambda_suite, reduce_raw, n_threads):
+    failures = []
+    threads = [threading.Thread(target=run_suite, args=(lambda_suite, reduce_raw, 5, failures))
+               for _ in range(n_threads)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    assert failures == []
+
+BATCH = [
+    "(\\x.\\y.x)\\z.\\w.z",
+    "(\\x.(x)x)\\x.(x)x",
+    "(((\\x.\\y.\\z.((x)z)(y)z)\\u.\\v.u)\\s.s)t",
+    "\\x.",
+    "((\\f.\\x.(f)(f)(f)x)\\g.\\y.(g)(g)y)\\z.z",
+    "(\\x.(y)x)w",
+] * 50
+
+@pytest.mark.parametrize("n_threads", [3, 0])
+def test_reduce_many_parallel(n_threads):
+    with PL.Interpreter(cycle_limit=5000) as interp:
+        expected = interp.reduce_many(BATCH, return_status=True)
+        assert interp.reduce_many(BATCH, return_status=True, threads=n_threads) == expected
+
+def test_module_level_threads():
+    expected = [PL.reduce_lambda(expr) for expr in BATCH[:6]]
+    failures = []
+
+    def run():
+        for _ in range(20):
+            results = [PL.reduce_lambda(expr) for expr in BATCH[:6]]
+            if results != expected:
+                failures.append(results)
+
+    threads = [threading.Thread(target=run) for _ in range(8)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    assert failures == []